@@ -0,0 +1,554 @@
+/// library: bitstream / micro-benchmarks des primitives de Bits::Stream
+/// + mesure du débit (bits/s) et du temps par opération (ns/op) de chaque primitive.
+/// + Bits::Stream : lectures/écritures de bits, agrandissement, seek, copie, instantanés partagés
+///   (Stream::freeze), déplacement, ==.
+/// + Bits::Block<N>, Bits::varBlock, Bits::PackedVector<N>.
+/// + enregistrements: lots (BitBatch.h) et schéma fixe (BitRecord.h).
+/// + affichage (BitDump.h), index rank/select (BitRank.h), opérations logiques entre flux
+///   (BitOps.h).
+/// + codage de colonnes (BitColumn.h), d'Elias-Fano (BitEliasFano.h), de petits messages par des
+///   tables partagées (BitRegistry.h); recherche dans un texte codé (BitSearch.h).
+/// + décodage paresseux (BitDecode.h) comparé au décodage dans un std::vector.
+/// + fichiers écrits/lus en parallèle du codage (BitFile.h).
+/// + sortie CSV sur la sortie standard (une ligne par mesure) pour comparaison entre versions.
+/// usage: BitStream-bench [fichier texte (défaut USconstitution.txt)] [--quick]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include "BitStream.h"
+#include "BitRank.h"
+#include "BitOps.h"
+#include "BitPacked.h"
+#include "BitColumn.h"
+#include "BitEliasFano.h"
+#include "BitSearch.h"
+#include "BitRegistry.h"
+#include "BitBatch.h"
+#include "BitRecord.h"
+#include "BitDecode.h"
+#include "BitFile.h"
+using namespace std;
+
+namespace {
+	/// empêche le compilateur d'éliminer un calcul dont le résultat n'est pas utilisé
+	template <class T> inline void keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		static volatile const T *sink;
+		sink = &value;
+#endif
+	}
+
+	/// durée minimale de chaque mesure (s) et nombre de répétitions (on garde la meilleure)
+	double	MinTime = 0.2;
+	int		Repeat = 5;
+
+	/// @brief mesure fn (qui effectue ops opérations portant sur bits bits) et affiche une ligne CSV.
+	/// @detail fn est répétée jusqu'à durer au moins MinTime; le meilleur temps sur Repeat mesures est retenu.
+	template <class F> void run(const string &name, const string &input, uint64_t ops, uint64_t bits, F fn) {
+		using clock = chrono::steady_clock;
+		double  best = 1e300;
+		for(int r=0;r<Repeat;++r) {
+			uint64_t	iterations = 0;
+			clock::time_point  start = clock::now();
+			double		elapsed = 0.0;
+			do {
+				fn();
+				++iterations;
+				elapsed = chrono::duration<double>(clock::now() - start).count();
+			} while (elapsed < MinTime / Repeat);
+			best = min(best, elapsed / double(iterations));
+		}
+		cout << name << ',' << input << ',' << ops << ',' << bits << ','
+			<< best * 1e9 / double(ops) << ','
+			<< (bits ? double(bits) / best : 0.0) << endl;
+	}
+
+	/// valeurs aléatoires de NBITS bits
+	vector<uint64_t> random_values(size_t n, Bits::Size_t nbits, unsigned seed) {
+		mt19937_64			gen(seed);
+		vector<uint64_t>	v(n);
+		for(auto &x : v) x = gen() & Bits::mask<uint64_t>(0, nbits);
+		return v;
+	}
+
+	/// flux de n bits aléatoires
+	Bits::Stream random_stream(Bits::Size_t n, unsigned seed) {
+		mt19937			gen(seed);
+		Bits::Stream	s;
+		for(Bits::Size_t i=0;i<n;++i) s << Bits::Bit(gen() & 1);
+		return s;
+	}
+
+	template <int NBITS> void bench_block(const string &input, const vector<uint64_t> &values) {
+		using Type = typename Bits::Block<NBITS>::Type;
+		vector<Bits::Block<NBITS>>  blocks;
+		for(uint64_t v : values) blocks.push_back(Bits::Block<NBITS>(Type(v & Bits::mask<uint64_t>(0, Bits::Size_t(NBITS)))));
+		const uint64_t  n = blocks.size(), bits = n * Bits::Size_t(NBITS);
+		string  suffix = "<" + to_string(NBITS) + ">";
+		run("block_write" + suffix, input, n, bits, [&] {
+			Bits::Stream  s;
+			for(const auto &b : blocks) s << b;
+			keep(s);
+		});
+		Bits::Stream  s;
+		for(const auto &b : blocks) s << b;
+		run("block_read" + suffix, input, n, bits, [&] {
+			s.seek(0);
+			Bits::Block<NBITS>  b;
+			while (!s.end_of_stream()) { s >> b; keep(b); }
+		});
+		run("block_read_unchecked" + suffix, input, n, bits, [&] {
+			s.seek(0);
+			Bits::Block<NBITS>  b;
+			for(uint64_t i=0;i<n;++i) { s.read<Bits::Unchecked>(b); keep(b); }
+		});
+	}
+
+	template <int NBITS> void bench_packed(const string &input, const vector<uint64_t> &values) {
+		using Type = typename Bits::PackedVector<NBITS>::value_type;
+		const uint64_t  n = values.size(), bits = n * Bits::Size_t(NBITS);
+		string  suffix = "<" + to_string(NBITS) + ">";
+		Bits::PackedVector<NBITS>  p(values.size(), 0);
+		run("packed_set" + suffix, input, n, bits, [&] {
+			for(size_t i=0;i<values.size();++i) p.set(i, Type(values[i]));
+			keep(p);
+		});
+		run("packed_get" + suffix, input, n, bits, [&] {
+			for(size_t i=0;i<values.size();++i) keep(p.get(i));
+		});
+	}
+
+	void bench_varblock(const string &input, const vector<uint64_t> &values, Bits::Size_t nbits) {
+		vector<Bits::varBlock>  blocks;
+		for(uint64_t v : values) blocks.push_back(Bits::varBlock(nbits, v & Bits::mask<uint64_t>(0, nbits)));
+		const uint64_t  n = blocks.size(), bits = n * nbits;
+		string  suffix = "<" + to_string(nbits) + ">";
+		run("varblock_write" + suffix, input, n, bits, [&] {
+			Bits::Stream  s;
+			for(const auto &b : blocks) s << b;
+			keep(s);
+		});
+		Bits::Stream  s;
+		for(const auto &b : blocks) s << b;
+		run("varblock_read" + suffix, input, n, bits, [&] {
+			s.seek(0);
+			Bits::varBlock  b(nbits, 0);
+			while (!s.end_of_stream()) { s >> b; keep(b); }
+		});
+	}
+}
+
+int main(int argc, char *argv[]) {
+	string  filename = "USconstitution.txt";
+	for(int i=1;i<argc;++i) {
+		if (string(argv[i]) == "--quick") { MinTime = 0.02; Repeat = 2; }
+		else filename = argv[i];
+	}
+
+	cout << "benchmark,input,ops,bits,ns_per_op,bits_per_s" << endl;
+
+	// données synthétiques
+	const Bits::Size_t  NbBits = 1u << 20, NbValues = 1u << 16;
+	const string		synth = "random";
+	{
+		mt19937				gen(1);
+		vector<Bits::Bit>	bits(NbBits);
+		for(auto &&b : bits) b = Bits::Bit(gen() & 1);
+		run("bit_write", synth, NbBits, NbBits, [&] {
+			Bits::Stream  s;
+			for(Bits::Bit b : bits) s << b;
+			keep(s);
+		});
+		Bits::Stream  s;
+		for(Bits::Bit b : bits) s << b;
+		run("bit_read", synth, NbBits, NbBits, [&] {
+			s.seek(0);
+			Bits::Bit  b;
+			while (s >> b) keep(b);
+		});
+	}
+	bench_block<1>(synth, random_values(NbValues, 1, 2));
+	bench_block<5>(synth, random_values(NbValues, 5, 3));
+	bench_block<12>(synth, random_values(NbValues, 12, 4));
+	bench_block<33>(synth, random_values(NbValues, 33, 5));
+	bench_block<64>(synth, random_values(NbValues, 64, 6));
+	for(Bits::Size_t w : {3u, 17u, 64u}) bench_varblock(synth, random_values(NbValues, w, 7), w);
+	bench_packed<5>(synth, random_values(NbValues, 5, 3));
+	bench_packed<33>(synth, random_values(NbValues, 33, 5));
+
+	// agrandissement: flux créé avec une zone minimale, comparé à une zone réservée
+	run("grow_from_1_unit", synth, NbBits / 32, NbBits, [&] {
+		Bits::Stream  s(32);
+		for(Bits::Size_t i=0;i<NbBits/32;++i) s.write_bits(i, 32);
+		keep(s);
+	});
+	run("grow_reserved", synth, NbBits / 32, NbBits, [&] {
+		Bits::Stream  s(NbBits + 32);
+		for(Bits::Size_t i=0;i<NbBits/32;++i) s.write_bits(i, 32);
+		keep(s);
+	});
+
+	// petits enregistrements (1 à 8 valeurs de 17 bits): un flux par enregistrement, ou un lot (BitBatch.h)
+	{
+		const Bits::Size_t  NbRecords = NbValues / 4;
+		const auto			values = random_values(NbValues, 17, 8);
+		vector<Bits::Size_t>  first(NbRecords + 1, 0);
+		for(Bits::Size_t r=0;r<NbRecords;++r) first[r+1] = first[r] + 1 + Bits::Size_t(values[r] % 8);
+		const auto  write = [&](Bits::Stream &s, Bits::Size_t r) {
+			s.write_bits(first[r+1] - first[r], 4);
+			for(Bits::Size_t i=first[r];i<first[r+1];++i) s.write_bits(Bits::Size_t(values[i % NbValues]), 17);
+		};
+		const uint64_t  bits = 4ull*NbRecords + 17ull*first[NbRecords];
+		run("records_separate", synth, NbRecords, bits, [&] {
+			for(Bits::Size_t r=0;r<NbRecords;++r) {
+				Bits::Stream  s;
+				write(s, r);
+				keep(s);
+			}
+		});
+		run("records_batch", synth, NbRecords, bits, [&] {
+			Bits::BatchWriter  batch;
+			for(Bits::Size_t r=0;r<NbRecords;++r) batch.add([&](Bits::Stream &s) { write(s, r); });
+			Bits::Stream  s;
+			s << batch;
+			keep(s);
+		});
+		Bits::BatchWriter  batch;
+		for(Bits::Size_t r=0;r<NbRecords;++r) batch.add([&](Bits::Stream &s) { write(s, r); });
+		Bits::Stream  s;
+		s << batch;
+		Bits::BatchReader  reader;
+		reader.read(s);
+		run("records_batch_open", synth, NbRecords, bits, [&] {
+			for(Bits::Size_t r=0;r<NbRecords;++r) keep(reader.open((r * 7919u) % NbRecords).get_bits(4));
+		});
+	}
+
+	// enregistrements à schéma fixe (3+5+12+27+1+40 bits): suite de Block<N> ou Bits::Record (BitRecord.h)
+	{
+		using Message = Bits::Record<Bits::Field<3>, Bits::Field<5>, Bits::Field<12>, Bits::Field<27>, Bits::Field<1>, Bits::Field<40>>;
+		const Bits::Size_t  NbRecords = NbValues / 4;
+		const auto			values = random_values(NbValues, 64, 9);
+		vector<Message>		messages(NbRecords);
+		for(Bits::Size_t r=0;r<NbRecords;++r) {
+			const uint64_t  v = values[r], w = values[r + NbRecords];
+			messages[r] = Message(Bits::Byte(v & 0x7), Bits::Byte((v >> 3) & 0x1F), uint16_t((v >> 8) & 0xFFF),
+								  uint32_t((v >> 20) & 0x7FFFFFF), Bits::Byte(v >> 63), w & 0xFFFFFFFFFFull);
+		}
+		const uint64_t  bits = uint64_t(Message::bits) * NbRecords;
+		run("record_blocks_write", synth, NbRecords, bits, [&] {
+			Bits::Stream  s;
+			for(const auto &m : messages)
+				s << Bits::Block<3>(m.get<0>()) << Bits::Block<5>(m.get<1>()) << Bits::Block<12>(m.get<2>())
+				  << Bits::Block<27>(m.get<3>()) << Bits::Block<1>(m.get<4>()) << Bits::Block<40>(m.get<5>());
+			keep(s);
+		});
+		run("record_write", synth, NbRecords, bits, [&] {
+			Bits::Stream  s;
+			Message::write(s, messages);
+			keep(s);
+		});
+		Bits::Stream  s;
+		Message::write(s, messages);
+		vector<Message>  rows;
+		run("record_read", synth, NbRecords, bits, [&] {
+			s.seek(0);
+			keep(Message::read(s, NbRecords, rows));
+		});
+		Message::Columns  columns;
+		run("record_read_columns", synth, NbRecords, bits, [&] {
+			s.seek(0);
+			keep(Message::read(s, NbRecords, columns));
+		});
+	}
+
+	// codage vers un fichier puis écriture d'un bloc, ou écriture par paquets pendant le codage (cf BitFile.h)
+	{
+		const char	   *path = "BitStream-bench.tmp";
+		const uint64_t  n = uint64_t(NbBits) * 4, bits = 7 * n;
+		const auto  value = [](uint64_t i) { return Bits::Size_t((i * 2654435761u) >> 25) & 0x7F; };
+		run("file_write_blocking", synth, n, bits, [&] {
+			Bits::Stream  s;
+			for(uint64_t i=0;i<n;++i) s.write_bits(value(i), 7);
+			ofstream  file(path, std::ios::out | std::ios::binary);
+			file.write(s.get_buffer(), streamsize(s.get_byte_size()));
+		});
+		run("file_write_pipelined", synth, n, bits, [&] {
+			Bits::FileWriter  out(path);
+			for(uint64_t i=0;i<n;++i) {
+				out.stream().write_bits(value(i), 7);
+				if ((i & 1023) == 0) out.commit();
+			}
+			out.close();
+		});
+		run("file_read_blocking", synth, n, bits, [&] {
+			Bits::Stream  s(Bits::Size_t(bits) + 32);
+			ifstream  file(path, std::ios::in | std::ios::binary);
+			file.read(s.get_buffer(), streamsize((bits + 7) / 8));
+			s.write_seek(Bits::Size_t(bits));
+			uint64_t  sum = 0;
+			for(uint64_t i=0;i<n;++i) sum += s.get_bits(7);
+			keep(sum);
+		});
+		run("file_read_pipelined", synth, n, bits, [&] {
+			Bits::FileReader  in(path, bits);
+			Bits::Stream	  &s = in.stream();
+			uint64_t  sum = 0;
+			for(uint64_t i=0;i<n;i+=64) {
+				in.ensure(7*64);
+				for(uint64_t k=i;k<std::min(i + 64, n);++k) sum += s.get_bits(7);
+			}
+			keep(sum);
+		});
+		std::remove(path);
+	}
+
+	// lecture/écriture par mots
+	{
+		run("write_bits<13>", synth, NbValues, 13ull * NbValues, [&] {
+			Bits::Stream  s;
+			for(Bits::Size_t i=0;i<NbValues;++i) s.write_bits(i, 13);
+			keep(s);
+		});
+		Bits::Stream  s;
+		for(Bits::Size_t i=0;i<NbValues;++i) s.write_bits(i, 13);
+		run("get_bits<13>", synth, NbValues, 13ull * NbValues, [&] {
+			s.seek(0);
+			for(Bits::Size_t i=0;i<NbValues;++i) keep(s.get_bits(13));
+		});
+	}
+
+	// seek, copie, déplacement, comparaison, concaténation, affichage, rank/select, and/xor/popcount
+	{
+		Bits::Stream  s = random_stream(NbBits, 8);
+		vector<Bits::Size_t>  positions = [&] {
+			mt19937  gen(9);
+			vector<Bits::Size_t>  p(NbValues);
+			for(auto &x : p) x = gen() % NbBits;
+			return p;
+		}();
+		run("seek", synth, NbValues, 0, [&] {
+			for(Bits::Size_t p : positions) { s.seek(p); Bits::Bit b; s >> b; keep(b); }
+		});
+		run("copy_construct", synth, 1, NbBits, [&] {
+			Bits::Stream  c(s);
+			keep(c);
+		});
+		Bits::Stream  target;
+		run("copy_assign", synth, 1, NbBits, [&] {
+			target = s;
+			keep(target);
+		});
+		// instantané partagé (cf Stream::freeze): copie en O(1), recopie des données à la première écriture
+		Bits::Stream  frozen(s);
+		const Bits::Stream::Frozen  snapshot = frozen.freeze();
+		run("frozen_copy", synth, 1, NbBits, [&] {
+			Bits::Stream  c(snapshot);
+			keep(c);
+		});
+		run("frozen_copy_write", synth, 1, NbBits, [&] {
+			Bits::Stream  c(snapshot);
+			c.write_bits(1, 1);
+			keep(c);
+		});
+		Bits::Stream  moved(s);
+		run("move_construct_assign", synth, 2, 0, [&] {
+			Bits::Stream  b(std::move(moved));
+			moved = std::move(b);
+			keep(moved);
+		});
+		Bits::Stream  other(s);
+		run("equal", synth, 1, NbBits, [&] {
+			bool  eq = (s == other);
+			keep(eq);
+		});
+		Bits::Stream  odd = random_stream(NbBits / 2 + 3, 10);
+		run("append_unaligned", synth, 1, NbBits, [&] {
+			Bits::Stream  c(odd);
+			c.append(s);
+			keep(c);
+		});
+		// affichage (cf BitDump.h) dans un tampon mémoire
+		ostringstream	text;
+		Bits::Dumper	hex(Bits::DumpFormat(Bits::DumpFormat::Hex, 32, 256, true));
+		Bits::Dumper	bin(Bits::DumpFormat(Bits::DumpFormat::Bin, 8, 128, true));
+		run("dump_hex", synth, 1, NbBits, [&] {
+			text.str("");
+			s.dump(text, hex);
+			keep(text);
+		});
+		run("dump_bin", synth, 1, NbBits, [&] {
+			text.str("");
+			s.dump(text, bin);
+			keep(text);
+		});
+		// index rank/select (cf BitRank.h)
+		run("rank_select_build", synth, 1, NbBits, [&] {
+			Bits::RankSelect  rs(s);
+			keep(rs);
+		});
+		Bits::RankSelect  rs(s);
+		run("rank1", synth, NbValues, 0, [&] {
+			for(Bits::Size_t p : positions) keep(rs.rank1(p));
+		});
+		run("select1", synth, NbValues, 0, [&] {
+			for(Bits::Size_t p : positions) keep(rs.select1(p % rs.ones()));
+		});
+		// opérations logiques entre flux (cf BitOps.h)
+		run("stream_and", synth, 1, NbBits, [&] {
+			Bits::Stream  r = s & odd;
+			keep(r);
+		});
+		Bits::Stream  acc(s);
+		run("stream_xor_assign", synth, 1, NbBits, [&] {
+			acc ^= other;
+			keep(acc);
+		});
+		run("popcount_and", synth, 1, NbBits, [&] {
+			keep(Bits::popcount<Bits::Op::And>(s, other));
+		});
+	}
+	{	// colonne d'horodatages: pas de 1000 +/- 8 (cf BitColumn.h)
+		mt19937_64  rng(13);
+		vector<uint64_t>  times(NbValues);
+		uint64_t  t = 1500000000000ull;
+		for(auto &x : times) x = (t += 1000 + rng() % 16 - 8);
+		Bits::CColumn  col;
+		run("column_encode", synth, NbValues, 64ull * NbValues, [&] {
+			Bits::Stream  c;
+			col.encode(times.data(), Bits::Size_t(times.size()), c);
+			keep(c);
+		});
+		Bits::Stream  c;
+		col.encode(times.data(), Bits::Size_t(times.size()), c);
+		vector<uint64_t>  out(times.size());
+		run("column_decode", synth, NbValues, 64ull * NbValues, [&] {
+			c.seek(0);
+			keep(col.decode(c, out.data(), Bits::Size_t(out.size())));
+		});
+	}
+	{	// suite croissante d'identifiants, écart moyen 32 (cf BitEliasFano.h)
+		mt19937_64  rng(17);
+		vector<uint64_t>  ids(NbValues), queries(NbValues);
+		uint64_t  id = 0;
+		for(auto &x : ids) x = (id += 1 + rng() % 63);
+		for(auto &x : queries) x = rng() % id;
+		run("elias_fano_build", synth, NbValues, 64ull * NbValues, [&] {
+			Bits::EliasFano  ef(ids);
+			keep(ef);
+		});
+		Bits::EliasFano  ef(ids);
+		run("elias_fano_iterate", synth, NbValues, 0, [&] {
+			for(uint64_t x : ef) keep(x);
+		});
+		run("elias_fano_next_geq", synth, NbValues, 0, [&] {
+			for(uint64_t x : queries) keep(ef.next_geq(x).index());
+		});
+	}
+
+	// texte réel: un caractère par Block<8>, puis par Block<7>
+	ifstream  file(filename, std::ios::in | std::ios::binary);
+	if (!file) {
+		cerr << "fichier " << filename << " introuvable: mesures sur texte ignorées" << endl;
+		return 0;
+	}
+	vector<char>  text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	string		  input = filename.substr(filename.find_last_of("/\\") + 1);
+	vector<uint64_t>  chars(text.begin(), text.end());
+	for(auto &c : chars) c &= 0xFF;
+	bench_block<8>(input, chars);
+	bench_block<7>(input, chars);
+	// recherche dans le texte codé à taille fixe, sans décodage (cf BitSearch.h)
+	{
+		Bits::Stream  packed;
+		Bits::CTF().compress(Bits::Bytes(text.begin(), text.end()), packed);
+		Bits::CTFSearch  search;
+		search.open(packed);
+		const uint64_t  n = text.size();
+		run("ctf_search", input, n, 8 * n, [&] {
+			keep(search.count_all("THE"));
+		});
+		run("ctf_search_long", input, n, 8 * n, [&] {
+			keep(search.count_all("PRESIDENT OF THE UNITED STATES"));
+		});
+	}
+	// décodage dans un vecteur puis traitement, ou traitement à la volée (cf BitDecode.h)
+	{
+		const Bits::Bytes  bytes(text.begin(), text.end());
+		const Bits::Size_t  n = Bits::Size_t(bytes.size());
+		Bits::Stream  coded;
+		Bits::CHuffman().encode(bytes.data(), n, coded);
+		Bits::CHuffman  huffman;
+		Bits::Bytes		out(n);
+		run("huffman_decode_sum", input, n, 8ull * n, [&] {
+			coded.seek(0);
+			huffman.decode(coded, out.data(), n);
+			uint64_t  sum = 0;
+			for(Bits::Byte c : out) sum += c;
+			keep(sum);
+		});
+		run("huffman_symbols_sum", input, n, 8ull * n, [&] {
+			coded.seek(0);
+			uint64_t  sum = 0;
+			for(Bits::Byte c : Bits::symbols(huffman, coded, n)) sum += c;
+			keep(sum);
+		});
+		Bits::Stream  packed;
+		for(Bits::Byte c : bytes) packed << Bits::Block<7>(Bits::Byte(c & 0x7F));
+		run("block_vector_sum<7>", input, n, 7ull * n, [&] {
+			packed.seek(0);
+			vector<Bits::Block<7>>  v;
+			while (!packed.end_of_stream()) {
+				Bits::Block<7>  b;
+				packed >> b;
+				v.push_back(b);
+			}
+			uint64_t  sum = 0;
+			for(const auto &b : v) sum += b.get();
+			keep(sum);
+		});
+		run("blocks_lazy_sum<7>", input, n, 7ull * n, [&] {
+			packed.seek(0);
+			uint64_t  sum = 0;
+			for(auto c : Bits::blocks<7>(packed)) sum += c;
+			keep(sum);
+		});
+	}
+	// petits messages (64 octets): table par message (Huffman) ou modèle partagé (cf BitRegistry.h)
+	{
+		const Bits::Size_t  m = 64, count = Bits::Size_t(text.size()) / m;
+		const Bits::Bytes	bytes(text.begin(), text.end());
+		Bits::ModelRegistry  registry;
+		const auto			 id = registry.train(bytes.data(), Bits::Size_t(bytes.size()));
+		Bits::CHuffman		 huffman;
+		Bits::CRegistered	 shared(registry, id);
+		Bits::Stream		 coded;
+		run("messages_huffman", input, count, 8ull * m * count, [&] {
+			coded.reset();
+			for(Bits::Size_t i=0;i<count;++i) huffman.encode(bytes.data() + i*m, m, coded);
+			keep(coded);
+		});
+		run("messages_registry", input, count, 8ull * m * count, [&] {
+			coded.reset();
+			for(Bits::Size_t i=0;i<count;++i) shared.encode(bytes.data() + i*m, m, coded);
+			keep(coded);
+		});
+		Bits::Bytes  out(m);
+		run("messages_registry_decode", input, count, 8ull * m * count, [&] {
+			coded.seek(0);
+			for(Bits::Size_t i=0;i<count;++i) shared.decode(coded, out.data(), m);
+			keep(out);
+		});
+	}
+	return 0;
+}
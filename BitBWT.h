@@ -0,0 +1,297 @@
+/// library: bitstream / BitBWT.h (transformée de Burrows-Wheeler)
+/// + Bits::BWT : transformée de Burrows-Wheeler d'un bloc (tableau des suffixes par SA-IS, en temps
+///   linéaire) et transformée inverse (une seule lecture mémoire aléatoire par octet).
+/// + Bits::MTF : move-to-front, puis codage des suites de 0 en base 2 bijective (RUNA/RUNB).
+/// + Bits::CBWT : codeur BWT + MTF + suites de 0 + Huffman (Bits::CHuffman), blocs codés et
+///   décodés en parallèle.
+
+#ifndef _BITBWT
+#define _BITBWT
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitCodec.h"
+#include "BitParallel.h"
+
+namespace Bits {
+	/// class Bits::BWT
+	/// Le bloc s (n octets) est complété par un sentinelle $ plus petit que tous les octets. La sortie
+	/// est la dernière colonne des rotations triées de s$, sans le $, et la ligne primary où il se trouve.
+	class BWT {
+	public:
+		/// taille maximale d'un bloc: la transformée inverse range un indice sur 24 bits
+		enum : Size_t { MaxBlock = (1u << 24) - 2 };
+
+		/// @brief transformée de s[0..n[ dans out[0..n[. Retourne la ligne du sentinelle.
+		Size_t forward(const Byte *s, Size_t n, Byte *out) {
+			BITS_ASSERT( (n <= MaxBlock) && "BWT: bloc trop grand");
+			if (n == 0) return 0;
+			text.resize(n + 1);
+			for(Size_t i=0;i<n;++i) text[i] = int(s[i]) + 1;
+			text[n] = 0;
+			sa.resize(n + 1);
+			sais(text.data(), sa.data(), int(n + 1), 257);
+			Size_t  primary = 0, k = 0;
+			for(Size_t i=0;i<=n;++i) {
+				if (sa[i] == 0) primary = i;
+				else out[k++] = s[sa[i] - 1];
+			}
+			return primary;
+		}
+		/// @brief transformée inverse de l[0..n[ (ligne du sentinelle: primary) dans out[0..n[.
+		/// Retourne faux si primary est hors du bloc.
+		bool inverse(const Byte *l, Size_t n, Size_t primary, Byte *out) {
+			if (n == 0) return true;
+			if ((n > MaxBlock) || (primary == 0) || (primary > n)) return false;
+			// C[c] = première ligne de la première colonne commençant par c (ligne 0: $)
+			Size_t  C[256] = {}, sum = 1;
+			for(Size_t i=0;i<n;++i) ++C[l[i]];
+			for(Size_t c=0;c<256;++c) { const Size_t  k = C[c]; C[c] = sum; sum += k; }
+			// next[j] = (ligne de la même occurrence dans la dernière colonne) << 8 | octet de la première colonne
+			next.resize(n + 1);
+			next[0] = primary << 8;
+			for(Size_t i=0;i<=n;++i) {
+				if (i == primary) continue;
+				const Byte  c = l[i - (i > primary)];
+				next[C[c]++] = (i << 8) | c;
+			}
+			uint32_t  p = next[primary];
+			for(Size_t i=0;i<n;++i) {
+				out[i] = Byte(p & 0xFF);
+				p = next[p >> 8];
+			}
+			return true;
+		}
+
+	protected:
+		std::vector<int>		text, sa;	///< espace de travail de forward (réutilisé)
+		std::vector<uint32_t>	next;		///< espace de travail de inverse (réutilisé)
+
+		/// construction du tableau des suffixes par SA-IS (Nong, Zhang, Chan). s[n-1] doit être le
+		/// seul symbole 0 (sentinelle); les symboles sont dans [0,K[.
+		static void sais(const int *s, int *SA, int n, int K) {
+			std::vector<Byte>  t(size_t(n), 0);		// 1 = type S (octets plutôt que bits: accès plus rapides)
+			t[size_t(n-1)] = 1;
+			for(int i=n-2;i>=0;--i) t[size_t(i)] = Byte((s[i] < s[i+1]) || ((s[i] == s[i+1]) && t[size_t(i+1)]));
+			const auto  lms = [&t](int i) { return (i > 0) && t[size_t(i)] && !t[size_t(i-1)]; };
+			std::vector<int>  count(static_cast<size_t>(K), 0), bkt(static_cast<size_t>(K));
+			for(int i=0;i<n;++i) ++count[size_t(s[i])];
+			// début (end = faux) ou fin de chaque seau
+			const auto  buckets = [&](bool end) {
+				int  sum = 0;
+				for(size_t c=0;c<bkt.size();++c) { sum += count[c]; bkt[c] = end ? sum : sum - count[c]; }
+			};
+			const auto  induce = [&]() {
+				buckets(false);
+				for(int i=0;i<n;++i) {
+					const int  j = SA[i] - 1;
+					if ((SA[i] > 0) && !t[size_t(j)]) SA[bkt[size_t(s[j])]++] = j;
+				}
+				buckets(true);
+				for(int i=n-1;i>=0;--i) {
+					const int  j = SA[i] - 1;
+					if ((SA[i] > 0) && t[size_t(j)]) SA[--bkt[size_t(s[j])]] = j;
+				}
+			};
+			// 1. tri des sous-chaînes LMS par induction
+			buckets(true);
+			std::fill(SA, SA + n, -1);
+			for(int i=1;i<n;++i) if (lms(i)) SA[--bkt[size_t(s[i])]] = i;
+			induce();
+			// 2. nommage des sous-chaînes LMS, rangées au début de SA
+			int  n1 = 0;
+			for(int i=0;i<n;++i) if (lms(SA[i])) SA[n1++] = SA[i];
+			std::fill(SA + n1, SA + n, -1);
+			int  name = 0, prev = -1;
+			for(int i=0;i<n1;++i) {
+				const int  pos = SA[i];
+				bool  diff = false;
+				for(int d=0;d<n;++d) {
+					if ((prev == -1) || (s[pos+d] != s[prev+d]) || (t[size_t(pos+d)] != t[size_t(prev+d)])) { diff = true; break; }
+					if ((d > 0) && (lms(pos+d) || lms(prev+d))) break;
+				}
+				if (diff) { ++name; prev = pos; }
+				SA[n1 + pos/2] = name - 1;
+			}
+			for(int i=n-1, j=n-1;i>=n1;--i) if (SA[i] >= 0) SA[j--] = SA[i];
+			// 3. tableau des suffixes du texte réduit (récursion si les noms ne sont pas uniques)
+			int  *s1 = SA + n - n1;
+			if (name < n1) sais(s1, SA, n1, name);
+			else for(int i=0;i<n1;++i) SA[s1[i]] = i;
+			// 4. induction du tableau des suffixes complet à partir des suffixes LMS triés
+			buckets(true);
+			for(int i=1, j=0;i<n;++i) if (lms(i)) s1[j++] = i;
+			for(int i=0;i<n1;++i) SA[i] = s1[SA[i]];
+			std::fill(SA + n1, SA + n, -1);
+			for(int i=n1-1;i>=0;--i) {
+				const int  j = SA[i];
+				SA[i] = -1;
+				SA[--bkt[size_t(s[j])]] = j;
+			}
+			induce();
+		}
+	};
+
+	/// class Bits::MTF
+	/// move-to-front suivi du codage des suites de 0: une suite de r zéros est écrite en base 2
+	/// bijective avec les symboles RUNA (0) et RUNB (1). Un rang v de 1 à 253 devient v+1; les rangs
+	/// 254 et 255 deviennent Escape suivi de v-254.
+	struct MTF {
+		enum : Byte { RunA = 0, RunB = 1, Escape = 255 };
+
+		/// @brief transformée de data[0..n[, symboles ajoutés à out.
+		static void forward(const Byte *data, Size_t n, std::vector<Byte> &out) {
+			Byte	order[256];
+			for(Size_t i=0;i<256;++i) order[i] = Byte(i);
+			Size_t  run = 0;
+			for(Size_t i=0;i<n;++i) {
+				const Byte  c = data[i];
+				if (order[0] == c) { ++run; continue; }
+				flush(run, out);
+				run = 0;
+				Size_t  v = 1;
+				while (order[v] != c) ++v;
+				memmove(order + 1, order, v);
+				order[0] = c;
+				if (v < 254) out.push_back(Byte(v + 1));
+				else { out.push_back(Escape); out.push_back(Byte(v - 254)); }
+			}
+			flush(run, out);
+		}
+		/// @brief transformée inverse des symboles sym[0..m[ dans out[0..n[. Retourne faux si les
+		/// symboles ne produisent pas exactement n octets.
+		static bool inverse(const Byte *sym, Size_t m, Byte *out, Size_t n) {
+			Byte	order[256];
+			for(Size_t i=0;i<256;++i) order[i] = Byte(i);
+			Size_t  k = 0;
+			uint64_t  run = 0, weight = 1;
+			for(Size_t i=0;i<m;++i) {
+				const Byte  s = sym[i];
+				if (s <= RunB) {	// chiffre de la suite de 0 en cours
+					run += weight << s;
+					weight <<= 1;
+					if (run > n - k) return false;
+					continue;
+				}
+				memset(out + k, order[0], size_t(run));
+				k += Size_t(run);
+				run = 0;
+				weight = 1;
+				Size_t  v = s - 1u;
+				if (s == Escape) {
+					if ((++i == m) || (sym[i] > 1)) return false;
+					v = 254u + sym[i];
+				}
+				if (k == n) return false;
+				const Byte  c = order[v];
+				memmove(order + 1, order, v);
+				order[0] = c;
+				out[k++] = c;
+			}
+			if (run > n - k) return false;
+			memset(out + k, order[0], size_t(run));
+			return k + run == n;
+		}
+
+	protected:
+		/// écriture d'une suite de r zéros (RUNA = 1, RUNB = 2 au rang de chaque chiffre)
+		static void flush(Size_t run, std::vector<Byte> &out) {
+			while (run) {
+				--run;
+				out.push_back((run & 1) ? RunB : RunA);
+				run >>= 1;
+			}
+		}
+	};
+
+	/// class Bits::CBWT
+	/// format: taille des blocs (32 bits), puis pour chaque bloc: ligne du sentinelle (32 bits), nombre
+	/// de symboles MTF (32 bits), taille en bits du bloc Huffman (32 bits), bloc Bits::CHuffman.
+	/// La taille de chaque bloc permet de retrouver tous les blocs avant de les décoder en parallèle.
+	class CBWT : public Codec {
+	public:
+		/// @param block_size taille des blocs en octets (BWT::MaxBlock au plus)
+		/// @param threads nombre de threads (0 = nombre de coeurs)
+		explicit CBWT(Size_t block_size = 1u << 20, Size_t threads = 0)
+			: block_size(std::max(Size_t(1), std::min(block_size, Size_t(BWT::MaxBlock)))),
+			  threads(threads ? threads : default_threads()) {}
+
+		uint32_t magic() const override { return Magic('B','W','T','0'); }
+		const char *name() const override { return "BWT"; }
+		/// le gain de la BWT ne se déduit pas de l'histogramme: coût du Huffman d'ordre 0 (majorant usuel)
+		uint64_t cost(const Histogram &h) const override {
+			return 32 + 96*((uint64_t(h.total) + block_size - 1) / block_size) + CHuffman().cost(h);
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			out.write_bits(block_size, 32);
+			const Size_t  nblocks = (n + block_size - 1) / block_size, T = std::min(threads, nblocks);
+			std::vector<Stream>  coded(nblocks);
+			parallel_run(T, [&](Size_t t) {
+				BWT					bwt;
+				CHuffman			huffman;
+				std::vector<Byte>	l, sym;
+				for(Size_t b=t;b<nblocks;b+=T) {
+					const Size_t  first = b*block_size, size = std::min(block_size, n - first);
+					l.resize(size);
+					const Size_t  primary = bwt.forward(data + first, size, l.data());
+					sym.clear();
+					MTF::forward(l.data(), size, sym);
+					Stream  s;
+					huffman.encode(sym.data(), Size_t(sym.size()), s);
+					Stream  &r = coded[b];
+					r.write_bits(primary, 32);
+					r.write_bits(Size_t(sym.size()), 32);
+					r.write_bits(s.get_bit_size(), 32);
+					r.append(s);
+				}
+			});
+			for(const Stream &s : coded) out.append(s);
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			const Size_t  bsize = in.get_bits(32);
+			if ((bsize == 0) || (bsize > BWT::MaxBlock)) return false;
+			// entêtes des blocs, puis copie de chaque bloc Huffman dans son propre flux
+			const Size_t  nblocks = (n + bsize - 1) / bsize, T = std::min(threads, nblocks);
+			std::vector<Size_t>  primary(nblocks), nsym(nblocks), start(nblocks), nbits(nblocks);
+			for(Size_t b=0;b<nblocks;++b) {
+				if (unread(in) < 96) return false;
+				primary[b] = in.get_bits(32);
+				nsym[b] = in.get_bits(32);
+				nbits[b] = in.get_bits(32);
+				start[b] = in.getReadPosition().LastBit();
+				// avant toute allocation: un octet donne au plus 2 symboles MTF (rang précédé de Escape)
+				if ((nsym[b] > 2*uint64_t(std::min(bsize, n - b*bsize)) + 1) || (unread(in) < nbits[b])) return false;
+				in.skip_bits(nbits[b]);
+			}
+			std::vector<Byte>  ok(T, 1);
+			parallel_run(T, [&](Size_t t) {
+				BWT					bwt;
+				CHuffman			huffman;
+				std::vector<Byte>	l, sym;
+				for(Size_t b=t;b<nblocks;b+=T) {
+					const Size_t  first = b*bsize, size = std::min(bsize, n - first);
+					Stream  s(nbits[b] + 1);
+					s.copy_bits(in, start[b], nbits[b]);
+					sym.resize(nsym[b]);
+					l.resize(size);
+					if (!huffman.decode(s, sym.data(), nsym[b])
+						|| !MTF::inverse(sym.data(), nsym[b], l.data(), size)
+						|| !bwt.inverse(l.data(), size, primary[b], data + first)) { ok[t] = 0; return; }
+				}
+			});
+			return std::find(ok.begin(), ok.end(), 0) == ok.end();
+		}
+		/// un bloc (au plus bsize octets) a une entête de 96 bits
+		uint64_t max_size(const Stream &in) const override {
+			const uint64_t  bits = unread(in);
+			return bits < 32 ? 0 : (bits - 32) / 96 * std::min(Size_t(in.peek_bits(32)), Size_t(BWT::MaxBlock));
+		}
+
+	protected:
+		Size_t	block_size, threads;
+	};
+}
+
+#endif
@@ -16,7 +16,15 @@
 #include <algorithm>
 #include <typeinfo>
 
-#ifdef _DEBUG
+/// BITSTREAM_UNCHECKED (à définir pour toute la compilation) supprime toutes les vérifications
+/// de la bibliothèque: assertions (BITS_ASSERT) et avertissements de _DEBUG.
+#ifdef BITSTREAM_UNCHECKED
+#define BITS_ASSERT(x) ((void)0)
+#else
+#define BITS_ASSERT(x) assert(x)
+#endif
+
+#if defined(_DEBUG) && !defined(BITSTREAM_UNCHECKED)
 #include <stdio.h>
 #define DEBUG(x) x
 #ifndef __PRETTY_FUNCTION__
@@ -45,10 +53,17 @@ namespace Bits {
 		return 8*sizeof(T);
 	}
 
+	/// politiques de vérification des lectures (cf Stream::read<Policy>)
+	/// Checked: vérifie la fin du flux et complète par des 0 (comportement des opérateurs >>).
+	/// Unchecked: aucune vérification; l'appelant garantit que les bits à lire ont été écrits
+	/// (par exemple après avoir validé la taille indiquée dans une entête).
+	struct Checked   { static constexpr bool check = true; };
+	struct Unchecked { static constexpr bool check = false; };
+
     /// @brief récupère le bit à la position pos (pos = 0 est le LSB)
     /// @detail Position doit être strictement intérieur à 8*sizeof(T).
     template <typename T> Bit get(const T &x, const Size_t Position) {
-        assert( (Position < 8*Size_t(sizeof(T))) && "Position au-delà du MSB");
+        BITS_ASSERT( (Position < 8*Size_t(sizeof(T))) && "Position au-delà du MSB");
         return (Bit)((x >> Position) & T(1u));
     }
 
@@ -90,23 +105,23 @@ namespace Bits {
 	/// Position doit être strictement intérieur à 8*sizeof(T).
 	/// Width doit être inférieur ou égal à 8*sizeof(T).
 	template <typename T> T mask(const Size_t Position, const Size_t Width) {
-		assert( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB");
-		assert( (Width <= 8*Size_t(sizeof(T)))   && "Width plus grand que le type");
+		BITS_ASSERT( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB");
+		BITS_ASSERT( (Width <= 8*Size_t(sizeof(T)))   && "Width plus grand que le type");
 		T  v = T(Width == 8*Size_t(sizeof(T)) ? 0 : T(~T(0)) << Width);
-		return static_cast<T>(~(v) << Position);
+		return static_cast<T>(T(~v) << Position);
 	};
 
 	/// @brief construction du masque associé au bit i (0 = LSB), à savoir tous les bits à 0 sauf le bit i.
 	/// @detail Position doit être strictement intérieur à 8*sizeof(T).
 	template <typename T> T bitmask(const Size_t Position) {
-		assert( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB" );
+		BITS_ASSERT( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB" );
 		return static_cast<T>(1) << Position;
 	}
 
 	/// @brief retourne x dans lequel la valeur du bit à la position Position est fixé à la valeur Value (0=LSB).
 	/// @detail Position doit être strictement intérieur à 8*sizeof(T).
 	template <typename T> T set(T x, Size_t Position, Bit Value) {
-		assert( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB");
+		BITS_ASSERT( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB");
 		T 	Mask = bitmask<T>(Position);
 		T   Result = (Value ? ~static_cast<T>(0) : static_cast<T>(0));
 		return (x & ~Mask) | (Result & Mask);
@@ -118,8 +133,8 @@ namespace Bits {
 	/// Si Position + Width dépasse 8*sizeof(T), la copie est tronquée au-delà.
 	/// Ni x ni y ne sont modifiés par cette fonction.
 	template <typename T> T set(const T &x, const Size_t Position, const Size_t Width, const T &y) {
-		assert( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB");
-		assert( (Width <= 8*Size_t(sizeof(T)))   && "Width plus grand que le type");
+		BITS_ASSERT( (Position < 8*Size_t(sizeof(T))) && "Position au delà du MSB");
+		BITS_ASSERT( (Width <= 8*Size_t(sizeof(T)))   && "Width plus grand que le type");
 		return static_cast<T>(
 			  ( x              & ( ~mask<T>(Position, Width) ))
 			| ((y << Position) & (  mask<T>(Position, Width) ))
@@ -138,6 +153,57 @@ namespace Bits {
 		return k;
 	}
 
+	/// @brief retourne les Width bits de poids faible de x dans l'ordre inverse (bit 0 <-> bit Width-1).
+	/// @detail Width doit être compris entre 1 et 8*sizeof(T). Les bits au-delà de Width sont perdus.
+	template <typename T> T Reverse(T x, Size_t Width = 8*Size_t(sizeof(T))) {
+		BITS_ASSERT( (Width >= 1) && (Width <= 8*Size_t(sizeof(T))) && "Width hors du type");
+		uint64_t  v = uint64_t(x);
+		v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+		v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+		v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+#if defined(__GNUC__) || defined(__clang__)
+		v = __builtin_bswap64(v);
+#else
+		v = ((v >> 8) & 0x00FF00FF00FF00FFull) | ((v & 0x00FF00FF00FF00FFull) << 8);
+		v = ((v >> 16) & 0x0000FFFF0000FFFFull) | ((v & 0x0000FFFF0000FFFFull) << 16);
+		v = (v >> 32) | (v << 32);
+#endif
+		return T(v >> (64 - Width));
+	}
+
+	/// @brief nombre de bits à 1 dans x.
+	inline Size_t PopCount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+		return Size_t(__builtin_popcountll(x));
+#else
+		x = x - ((x >> 1) & 0x5555555555555555ull);
+		x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+		x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return Size_t((x * 0x0101010101010101ull) >> 56);
+#endif
+	}
+
+	/// @brief position (0 = LSB) du bit à 1 de rang r (0 = premier) dans x.
+	/// @detail r doit être strictement inférieur à PopCount(x).
+	inline Size_t Select(uint64_t x, Size_t r) {
+		BITS_ASSERT( (r < PopCount(x)) && "rang au-delà du nombre de bits à 1");
+		Size_t  pos = 0;
+		// octet contenant le bit cherché, puis bit dans l'octet
+		for(Size_t c;(c = PopCount(x & 0xFF)) <= r;x >>= 8, pos += 8) r -= c;
+		for(;;x >>= 1, ++pos)
+			if ((x & 1) && (r-- == 0)) return pos;
+	}
+
+	/// @brief nombre de bits à 0 avant le premier bit à 1 de x (0 = LSB). x doit être non nul.
+	inline Size_t TrailingZeros(uint64_t x) {
+		BITS_ASSERT( x && "TrailingZeros: x est nul");
+#if defined(__GNUC__) || defined(__clang__)
+		return Size_t(__builtin_ctzll(x));
+#else
+		return PopCount((x & (0 - x)) - 1);
+#endif
+	}
+
     template <class T> T RotateLeft(T bits, int rot) {
         return (T(bits << rot) | T(bits >> T( 8*sizeof(T) - T(rot))));
     }
@@ -0,0 +1,149 @@
+/// library: bitstream / BitBatch.h (lots d'enregistrements dans un flux unique)
+/// + Bits::BatchWriter : écriture de nombreux petits enregistrements à la suite dans un même flux,
+///   sans flux, entête ni mot partiel par enregistrement.
+/// + annuaire des positions de fin des enregistrements, codé par Bits::EliasFano (écarts entre
+///   positions: 2 + log2(taille moyenne en bits) bits par enregistrement environ).
+/// + Bits::BatchReader : relecture d'un lot, accès direct à l'enregistrement i ou parcours de tous.
+
+#ifndef _BITBATCH
+#define _BITBATCH
+#include <cstdint>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitCodec.h"
+#include "BitEliasFano.h"
+
+namespace Bits {
+	/// class Bits::BatchWriter
+	/// Chaque enregistrement est écrit dans stream() (à sa position d'écriture), puis terminé par
+	/// close(), qui note sa position de fin. Les enregistrements se suivent au bit près.
+	/// format écrit par operator<<: annuaire (Bits::EliasFano des positions de fin), taille des
+	/// données en bits (32 bits), puis les données.
+	class BatchWriter {
+	public:
+		/// @param reserve_bytes place réservée pour les données (évite les agrandissements successifs)
+		explicit BatchWriter(Size_t reserve_bytes = 0) {
+			if (reserve_bytes) data.request_storage_size(reserve_bytes);
+		}
+
+		/// flux dans lequel écrire l'enregistrement courant
+		inline Stream& stream() { return data; }
+		/// @brief termine l'enregistrement courant. Retourne son indice.
+		inline Size_t close() {
+			ends.push_back(data.get_bit_size());
+			return Size_t(ends.size() - 1);
+		}
+		/// @brief ajoute un enregistrement écrit par write(stream()). Retourne son indice.
+		template <class F> inline Size_t add(F write) {
+			write(data);
+			return close();
+		}
+		/// @brief ajoute un enregistrement codé par codec (sans l'entête de Codec::compress: la taille
+		/// des données doit être connue au décodage). Retourne son indice.
+		inline Size_t add(Codec &codec, const Byte *bytes, Size_t n) {
+			codec.encode(bytes, n, data);
+			return close();
+		}
+
+		/// nombre d'enregistrements terminés et taille des données (bits)
+		inline Size_t size() const { return Size_t(ends.size()); }
+		inline Size_t bit_size() const { return data.get_bit_size(); }
+		/// vide le lot (la mémoire du flux est conservée)
+		inline void clear() {
+			data.reset();
+			ends.clear();
+		}
+
+		/// @brief écriture du lot. Tous les enregistrements doivent être terminés.
+		friend Stream& operator<<(Stream &stream, const BatchWriter &b) {
+			BITS_ASSERT( (b.data.get_bit_size() == (b.ends.empty() ? 0 : b.ends.back())) && "BatchWriter: enregistrement non terminé" );
+			stream << EliasFano(b.ends);
+			stream.write_bits(b.data.get_bit_size(), 32);
+			stream.copy_bits(b.data, 0, b.data.get_bit_size());
+			return stream;
+		}
+
+	protected:
+		Stream					data;	///< enregistrements à la suite
+		std::vector<uint64_t>	ends;	///< position de fin de chaque enregistrement
+	};
+
+	/// class Bits::BatchReader
+	/// Les données du lot sont copiées dans un flux propre au lecteur, dont le curseur de lecture est
+	/// placé au début de l'enregistrement demandé: un lecteur ne doit donc être utilisé que par un
+	/// thread à la fois.
+	class BatchReader {
+	public:
+		BatchReader() = default;
+
+		/// @brief relecture d'un lot écrit par Bits::BatchWriter, à partir du curseur de lecture (qui avance).
+		/// @detail retourne faux (lecteur inchangé) si le lot est incohérent ou incomplet.
+		bool read(Stream &in) {
+			EliasFano  dir;
+			if (!dir.read(in)) return false;
+			if (in.get_bit_size() - in.getReadPosition().LastBit() < 32) return false;
+			const Size_t  nbits = in.get_bits(32);
+			if ((dir.size() ? dir.back() : 0) != nbits) return false;
+			// avant l'allocation: l'annuaire (quelques bits) peut annoncer 2^32 bits de données
+			if (in.get_bit_size() - in.getReadPosition().LastBit() < nbits) return false;
+			const Size_t  from = in.getReadPosition().LastBit();
+			Stream  d(nbits + 1);
+			if (!d.copy_bits(in, from, nbits)) return false;
+			in.skip_bits(nbits);
+			ends = std::move(dir);
+			data = std::move(d);
+			return true;
+		}
+
+		/// nombre d'enregistrements et taille des données (bits)
+		inline Size_t size() const { return ends.size(); }
+		inline Size_t bit_size() const { return data.get_bit_size(); }
+		/// position de début et de fin de l'enregistrement i dans les données
+		inline Size_t begin(Size_t i) const { return i ? Size_t(ends[i - 1]) : 0; }
+		inline Size_t end(Size_t i) const { return Size_t(ends[i]); }
+
+		/// @brief place le curseur de lecture au début de l'enregistrement i et retourne le flux.
+		Stream& open(Size_t i) {
+			BITS_ASSERT( (i < size()) && "BatchReader: enregistrement inexistant" );
+			seek(begin(i));
+			return data;
+		}
+		/// @brief décode l'enregistrement i (n octets) par codec.
+		/// Retourne faux si le décodage échoue ou déborde de l'enregistrement.
+		bool decode(Size_t i, Codec &codec, Byte *bytes, Size_t n) {
+			if (i >= size()) return false;
+			open(i);
+			return codec.decode(data, bytes, n) && (data.getReadPosition().LastBit() <= end(i));
+		}
+		/// @brief parcours: read(i, stream, fin) est appelé pour chaque enregistrement, le curseur de lecture
+		/// du flux étant au début de l'enregistrement i, qui se termine au bit fin. Le parcours s'arrête
+		/// dès que read retourne faux (for_each retourne alors faux).
+		/// @detail les positions de fin sont lues séquentiellement dans l'annuaire (sans select).
+		template <class F> bool for_each(F read) {
+			Size_t  first = 0;
+			for(auto it=ends.begin();it!=ends.end();++it) {
+				const Size_t  last = Size_t(*it);
+				seek(first);
+				if (!read(it.index(), data, last)) return false;
+				first = last;
+			}
+			return true;
+		}
+
+	protected:
+		EliasFano	ends;	///< annuaire des positions de fin
+		Stream		data;	///< enregistrements
+
+		/// curseur de lecture placé exactement au bit p, fin des données comprise (enregistrements
+		/// vides en fin de lot): Stream::seek refuse la fin des données, d'où skip_bits
+		inline void seek(Size_t p) {
+			if (!data.seek(p)) {
+				data.seek(0);
+				data.skip_bits(p);
+			}
+		}
+	};
+}
+
+#endif
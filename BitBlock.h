@@ -11,8 +11,7 @@
 #include <algorithm>
 #include "BitBase.h"
 
-#undef _DEBUG
-#ifdef _DEBUG
+#if defined(_DEBUG) && !defined(BITSTREAM_UNCHECKED)
 #include <stdio.h>
 #define DEBUG(x) x
 #ifndef __PRETTY_FUNCTION__
@@ -142,13 +141,9 @@ namespace Bits {
 		/// Si le résultat est négatif, on obtient le complément à 1.
 		/// Le Block renvoyé a le nombre de bit valide du plus grand des deux.
 		friend Block<NBITS> operator-(const Block<NBITS> &x1, const Block<NBITS> &x2) {
-			if (x1.bits > x2.bits) {
-				return Block<NBITS>((x1.bits - x2.bits) & x1.mask());
-			}
-			else {
-				Type    carry = Type(1) << Size_t(NBITS);
-				return Block<NBITS>((carry - x2.bits + x1.bits) & x1.mask());
-			}
+			// 2^NBITS - x2 + x1 modulo 2^NBITS: la soustraction non signée donne directement ce résultat
+			// (2^NBITS n'est pas représentable lorsque NBITS = 8*sizeof(Type))
+			return Block<NBITS>(Type(x1.bits - x2.bits) & x1.mask());
 		}
 
 		/// @brief surcharge pour affichage dans un flux de sortie
@@ -176,16 +171,13 @@ namespace Bits {
 		inline varBlock() : valid(maxbits), bits(0u) {}
 		/// @brief constructeur taille support (valeur non initialisée).
 		inline varBlock(Size_t _valid) : valid(_valid) {
-			if ( (_valid>=0) && (_valid<=maxbits) ) {
-				std::cout << "arg";
-			}
-			assert( (_valid>=0) && (_valid<=maxbits) );
+			BITS_ASSERT( _valid<=maxbits );
 		}
 		/// @brief constructeur taille support + valeur.
 		/// les bits au-delà du support valide sont perdus.
 		inline varBlock(Size_t _valid, Type bits_to_store) :
 			valid(_valid), bits( bits_to_store & Bits::mask<Type>(0u,valid) ) {
-			assert( (_valid>=0) && (_valid<=maxbits) );
+			BITS_ASSERT( _valid<=maxbits );
             DEBUG( if (bits != bits_to_store) WARNING("Perte de précision (la valeur %u nécessite plus de %u bits)",Size_t(bits_to_store),Size_t(valid)) );
 		}
 		//@}
@@ -211,7 +203,7 @@ namespace Bits {
 		/// @brief fixe la valeur du bit Position à BitValue, mais seulement si Position est dans le support valide.
 		/// Donc, il n'est possible de fixe un bit à l'extérieur des bits valides.
 		inline void set_bit(Size_t Position, Bit BitValue) {
-            assert( Position<maxbits );
+            BITS_ASSERT( Position<maxbits );
 			if (Position < valid) bits = ::Bits::set<Type>(bits, Position, BitValue);
             else { DEBUG(WARNING("Echec (Position = %d plus grand que valid = %d)",Position,valid)); }
 		}
@@ -220,7 +212,7 @@ namespace Bits {
 		/// Si le nombre de bits augmente, il est garanti que les bits gagnés sont des 0.
 		/// Si le nombre de bits diminue, les bits perdus à l'extérieur du support sont mis à zéro.
 		inline void set_valid(Size_t _valid) {
-            assert( (_valid>=1) && (_valid<=maxbits) );       // au moins 1 bit
+            BITS_ASSERT( (_valid>=1) && (_valid<=maxbits) );       // au moins 1 bit
 			if (_valid > valid) { clean();  valid = _valid; }
 			else if (_valid < valid) { valid=_valid; clean(); }
 		}
@@ -238,7 +230,7 @@ namespace Bits {
 		inline Size_t get_valid() const { return valid; };
         /// @brief retourne le bit souhaité
         inline Bit get_bit(Size_t Position) const {
-            assert( Position<valid );
+            BITS_ASSERT( Position<valid );
             return ::Bits::get<Type>(bits,Position);
         };
         /// @brief test si le contenu est zéro
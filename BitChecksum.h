@@ -0,0 +1,97 @@
+/// library: bitstream / BitChecksum.h (somme de contrôle incrémentale)
+/// + Bits::CRC32C : CRC-32C (Castagnoli) calculé par morceaux, instruction crc32 du processeur
+///   si elle est disponible (x86 SSE4.2), tables sinon.
+
+#ifndef _BITCHECKSUM
+#define _BITCHECKSUM
+#include <cstdint>
+#include <cstring>
+#include "BitBase.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define BITS_CRC32C_SSE42
+#endif
+
+namespace Bits {
+	/// class Bits::CRC32C
+	/// Le CRC est mis à jour à chaque appel de update(), ce qui permet de le calculer au fil de
+	/// l'écriture ou de la lecture des données, sans deuxième passe.
+	class CRC32C {
+	protected:
+		uint32_t	state = ~uint32_t(0);	///< CRC courant (complémenté)
+
+		/// tables pour le calcul logiciel par paquets de 8 octets (slicing-by-8)
+		static const uint32_t (&tables())[8][256] {
+			static uint32_t  tab[8][256];
+			static bool      init = [] {
+				for(uint32_t i=0;i<256;++i) {
+					uint32_t  c = i;
+					for(int k=0;k<8;++k) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+					tab[0][i] = c;
+				}
+				for(uint32_t i=0;i<256;++i)
+					for(int t=1;t<8;++t) tab[t][i] = (tab[t-1][i] >> 8) ^ tab[0][tab[t-1][i] & 0xFF];
+				return true;
+			}();
+			(void)init;
+			return tab;
+		}
+		static uint32_t software(uint32_t crc, const Byte *p, size_t n) {
+			const uint32_t  (&t)[8][256] = tables();
+			for(;n >= 8;n -= 8, p += 8) {
+				uint32_t  lo, hi;
+				memcpy(&lo, p, 4);
+				memcpy(&hi, p + 4, 4);
+				lo ^= crc;
+				crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+					^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+			}
+			for(;n;--n, ++p) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+			return crc;
+		}
+#ifdef BITS_CRC32C_SSE42
+		__attribute__((target("sse4.2")))
+		static uint32_t hardware(uint32_t crc, const Byte *p, size_t n) {
+#ifdef __x86_64__
+			uint64_t  c = crc;
+			for(;n >= 8;n -= 8, p += 8) {
+				uint64_t  v;
+				memcpy(&v, p, 8);
+				c = _mm_crc32_u64(c, v);
+			}
+			crc = uint32_t(c);
+#endif
+			for(;n;--n, ++p) crc = _mm_crc32_u8(crc, *p);
+			return crc;
+		}
+		static bool has_hardware() {
+			static const bool  sse42 = __builtin_cpu_supports("sse4.2");
+			return sse42;
+		}
+#endif
+		/// choix du calcul matériel ou logiciel
+		static uint32_t compute(uint32_t crc, const Byte *p, size_t n) {
+#ifdef BITS_CRC32C_SSE42
+			if (has_hardware()) return hardware(crc, p, n);
+#endif
+			return software(crc, p, n);
+		}
+	public:
+		/// constructeur: CRC des données vides
+		CRC32C() = default;
+		/// remise à zéro
+		inline void reset() { state = ~uint32_t(0); }
+		/// ajoute n octets au calcul
+		inline CRC32C& update(const void *data, size_t n) {
+			state = compute(state, static_cast<const Byte*>(data), n);
+			return *this;
+		}
+		/// valeur du CRC des données ajoutées jusqu'ici
+		inline uint32_t value() const { return ~state; }
+		/// CRC d'un bloc de données
+		static uint32_t of(const void *data, size_t n) { return CRC32C().update(data, n).value(); }
+	};
+}
+
+#endif
@@ -0,0 +1,463 @@
+/// library: bitstream / BitCodec.h (codeurs sur Bits::Stream et conteneur adaptatif)
+/// + classe mère Bits::Codec (méthodes virtuelles encode/decode) et format de fichier commun:
+///   magic number (32 bits), taille des données (32 bits), puis données codées.
+/// + Bits::CStored (stockage brut), Bits::CTF (taille fixe), Bits::CHuffman, Bits::CLZ (LZ77)
+/// + Bits::CAdaptive : découpage en blocs et choix du codeur par bloc
+/// + CRC-32C optionnel des données d'origine dans le pied du conteneur adaptatif
+
+#ifndef _BITCODEC
+#define _BITCODEC
+#include <vector>
+#include <array>
+#include <queue>
+#include <fstream>
+#include "BitStream.h"
+#include "BitChecksum.h"
+
+namespace Bits {
+	/// données à coder/décodées
+	using Bytes = std::vector<Byte>;
+
+	/// construction d'un magic number à partir de 4 caractères
+	constexpr uint32_t Magic(char a, char b, char c, char d) {
+		return uint32_t(Byte(a)) | (uint32_t(Byte(b)) << 8) | (uint32_t(Byte(c)) << 16) | (uint32_t(Byte(d)) << 24);
+	}
+
+	/// histogramme des octets d'un bloc de données
+	struct Histogram {
+		uint32_t	count[256] = {};	///< nombre d'occurrences de chaque octet
+		Size_t		total = 0;			///< nombre d'octets comptés
+
+		Histogram() = default;
+		Histogram(const Byte *data, Size_t n) { add(data, n); }
+		/// ajoute n octets à l'histogramme
+		inline void add(const Byte *data, Size_t n) {
+			for(Size_t i=0;i<n;++i) ++count[data[i]];
+			total += n;
+		}
+		/// nombre de symboles différents
+		inline Size_t symbols() const {
+			Size_t  k = 0;
+			for(Size_t s=0;s<256;++s) k += (count[s] != 0);
+			return k;
+		}
+	};
+
+	/// class Bits::Codec
+	/// classe mère de tous les codeurs. encode/decode travaillent sur un bloc dont la taille est
+	/// connue des deux côtés: la table de codage éventuelle est écrite par encode et relue par decode.
+	class Codec {
+	public:
+		virtual ~Codec() = default;
+		/// magic number identifiant le type de compression dans l'entête de fichier
+		virtual uint32_t magic() const = 0;
+		/// nom du codeur (pour affichage)
+		virtual const char *name() const = 0;
+		/// @brief coût en bits (table comprise) du codage d'un bloc dont h est l'histogramme.
+		virtual uint64_t cost(const Histogram &h) const = 0;
+		/// @brief code les n octets de data dans out (table de codage comprise).
+		virtual void encode(const Byte *data, Size_t n, Stream &out) = 0;
+		/// @brief décode n octets depuis in dans data.
+		/// Retourne faux si les données lues sont incohérentes.
+		virtual bool decode(Stream &in, Byte *data, Size_t n) = 0;
+		/// @brief nombre maximal d'octets décodables à partir du curseur de lecture de in (borne la
+		/// taille lue dans l'entête avant toute allocation). Par défaut: pas de borne.
+		virtual uint64_t max_size(const Stream &) const { return ~uint64_t(0); }
+
+		/// @brief compression complète: entête (magic number, taille) suivie des données codées.
+		void compress(const Bytes &in, Stream &out) {
+			Stats::ScopedTimer  timer(Stats::EncodeCalls, Stats::EncodeNanoseconds);
+			out.write_bits(magic(), 32);
+			out.write_bits(Size_t(in.size()), 32);
+			encode(in.data(), Size_t(in.size()), out);
+		}
+		/// @brief décompression complète (relecture de l'entête à partir du curseur de lecture).
+		/// Retourne faux si le magic number ne correspond pas ou si les données sont incohérentes.
+		bool decompress(Stream &in, Bytes &out) {
+			Stats::ScopedTimer  timer(Stats::DecodeCalls, Stats::DecodeNanoseconds);
+			if (in.get_bits(32) != magic()) return false;
+			const Size_t  n = in.get_bits(32);
+			if (n > max_size(in)) return false;
+			out.resize(n);
+			return decode(in, out.data(), n);
+		}
+
+	protected:
+		/// nombre de bits restant à lire dans in
+		static inline uint64_t unread(const Stream &in) { return in.get_bit_size() - in.getReadPosition().LastBit(); }
+	};
+
+	/// @brief sauvegarde les données écrites d'un flux dans un fichier.
+	inline bool save(const char *filename, const Stream &stream) {
+		std::ofstream  file(filename, std::ios::out | std::ios::binary);
+		file.write(stream.get_buffer(), stream.get_byte_size());
+		return bool(file);
+	}
+	/// @brief charge un fichier dans un flux (vidé au préalable). Le curseur de lecture est au début.
+	inline bool load(const char *filename, Stream &stream) {
+		std::ifstream  file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file) return false;
+		Size_t  nBytes = Size_t(file.tellg());
+		file.seekg(0);
+		stream.reset();
+		stream.request_storage_size(nBytes + Size_t(sizeof(Stream::storage_type)));
+		file.read(stream.get_buffer(), nBytes);
+		stream.write_seek(8*nBytes);
+		return bool(file);
+	}
+
+	/// class Bits::CStored
+	/// stockage brut des octets (copie mémoire après alignement sur un bloc du flux).
+	class CStored : public Codec {
+	public:
+		uint32_t magic() const override { return Magic('S','T','O','R'); }
+		const char *name() const override { return "Stored"; }
+		uint64_t cost(const Histogram &h) const override {
+			return 8ull*h.total + Stream::storage_unit_size - 1;
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			out.write_bytes(data, n);
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			return in.read_bytes(data, n) == n;
+		}
+		uint64_t max_size(const Stream &in) const override { return unread(in) / 8; }
+	};
+
+	/// class Bits::CTF
+	/// codage à taille fixe: chaque symbole est remplacé par son indice dans la table des symboles
+	/// présents, sur le plus petit nombre de bits possible.
+	/// format: nombre de symboles - 1 (8 bits), table des symboles (8 bits chacun), codes.
+	class CTF : public Codec {
+	public:
+		/// nombre de bits d'un code pour une table de k symboles
+		static Size_t width(Size_t k) { return k > 1 ? MSB(k-1) : 0; }
+
+		uint32_t magic() const override { return Magic('C','T','F','0'); }
+		const char *name() const override { return "CTF"; }
+		uint64_t cost(const Histogram &h) const override {
+			Size_t  k = h.symbols();
+			return 8ull + 8ull*k + uint64_t(width(k))*h.total;
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			encode(data, n, Histogram(data, n), out);
+		}
+		/// @brief codage avec un histogramme déjà calculé
+		void encode(const Byte *data, Size_t n, const Histogram &h, Stream &out) {
+			if (n == 0) return;
+			Byte	code[256];
+			Size_t  k = 0;
+			for(Size_t s=0;s<256;++s) if (h.count[s]) code[s] = Byte(k++);
+			out.write_bits(k-1, 8);
+			for(Size_t s=0;s<256;++s) if (h.count[s]) out.write_bits(s, 8);
+			Size_t  w = width(k);
+			if (w) for(Size_t i=0;i<n;++i) out.write_bits(code[data[i]], w);
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			if (n == 0) return true;
+			Byte	symbol[256];
+			Size_t  k = in.get_bits(8) + 1;
+			for(Size_t i=0;i<k;++i) symbol[i] = Byte(in.get_bits(8));
+			Size_t  w = width(k);
+			for(Size_t i=0;i<n;++i) {
+				Size_t  c = w ? in.get_bits(w) : 0;
+				if (c >= k) return false;
+				data[i] = symbol[c];
+			}
+			return true;
+		}
+		/// pas de borne si tous les octets sont égaux (codes de 0 bit)
+		uint64_t max_size(const Stream &in) const override {
+			const uint64_t  bits = unread(in);
+			const Size_t	k = Size_t(in.peek_bits(8)) + 1, w = width(k);
+			if (bits < 8 + 8ull*k) return 0;
+			return w ? (bits - 8 - 8ull*k) / w : ~uint64_t(0);
+		}
+	};
+
+	/// class Bits::CHuffman
+	/// codage de Huffman canonique (longueur de code limitée à MaxLength bits).
+	/// format: longueur du code de chaque octet (4 bits x 256), codes.
+	/// Le premier bit d'un code est le premier bit écrit dans le flux, ce qui permet un décodage
+	/// par table indexée par les MaxLength bits suivants du flux.
+	class CHuffman : public Codec {
+	public:
+		static constexpr Size_t MaxLength = 12;
+		using Lengths = std::array<Byte, 256>;
+
+		/// @brief calcule les longueurs de code optimales (limitées à MaxLength) pour l'histogramme h.
+		/// @detail si une longueur dépasse MaxLength, les effectifs sont divisés par 2 et le calcul recommencé.
+		static Lengths lengths(const Histogram &h) {
+			Lengths				len{};
+			std::vector<uint64_t>	freq(h.count, h.count + 256);
+			for(;;) {
+				// noeuds 0..255 = feuilles, puis noeuds internes; parent[] permet de calculer les profondeurs
+				using Node = std::pair<uint64_t, Size_t>;
+				std::priority_queue<Node, std::vector<Node>, std::greater<Node>>  heap;
+				std::vector<Size_t>  parent(512, 0);
+				for(Size_t s=0;s<256;++s) if (freq[s]) heap.push({freq[s], s});
+				if (heap.empty()) return len;
+				if (heap.size() == 1) { len[heap.top().second] = 1; return len; }
+				Size_t  next = 256;
+				while (heap.size() > 1) {
+					Node  a = heap.top(); heap.pop();
+					Node  b = heap.top(); heap.pop();
+					parent[a.second] = parent[b.second] = next;
+					heap.push({a.first + b.first, next++});
+				}
+				// les noeuds internes sont créés après leurs fils: on descend depuis la racine
+				Size_t  root = next - 1, maxlen = 0;
+				std::vector<Size_t>  depth(512, 0);
+				for(Size_t i=root;i-- > 256;) depth[i] = depth[parent[i]] + 1;
+				for(Size_t s=0;s<256;++s) if (freq[s]) {
+					depth[s] = depth[parent[s]] + 1;
+					maxlen = std::max(maxlen, depth[s]);
+				}
+				if (maxlen <= MaxLength) {
+					for(Size_t s=0;s<256;++s) len[s] = Byte(depth[s]);
+					return len;
+				}
+				for(auto &f : freq) if (f) f = (f >> 1) | 1;
+			}
+		}
+		/// @brief codes canoniques associés aux longueurs (bits dans l'ordre du flux).
+		static std::array<uint32_t, 256> codes(const Lengths &len) {
+			std::array<uint32_t, 256>  code{};
+			uint32_t  next = 0;
+			for(Size_t l=1;l<=MaxLength;++l, next <<= 1)
+				for(Size_t s=0;s<256;++s) if (len[s] == l) {
+					// inversion des l bits du code pour que son MSB soit écrit en premier
+					uint32_t  c = next++, r = 0;
+					for(Size_t i=0;i<l;++i) r |= ((c >> i) & 1u) << (l-1-i);
+					code[s] = r;
+				}
+			return code;
+		}
+		/// @brief table de décodage (symbole | longueur << 8) indexée par les MaxLength bits suivants.
+		/// Retourne faux si les longueurs ne définissent pas un code préfixe.
+		static bool table(const Lengths &len, std::vector<uint16_t> &tab) {
+			uint64_t  kraft = 0;
+			for(Size_t s=0;s<256;++s) {
+				if (len[s] > MaxLength) return false;
+				if (len[s]) kraft += 1ull << (MaxLength - len[s]);
+			}
+			if (kraft > (1ull << MaxLength)) return false;
+			std::array<uint32_t, 256>  code = codes(len);
+			tab.assign(Size_t(1) << MaxLength, 0);
+			for(Size_t s=0;s<256;++s) if (len[s])
+				for(Size_t j=code[s];j<tab.size();j+=Size_t(1) << len[s])
+					tab[j] = uint16_t(s | (Size_t(len[s]) << 8));
+			return true;
+		}
+
+		uint32_t magic() const override { return Magic('H','U','F','0'); }
+		const char *name() const override { return "Huffman"; }
+		uint64_t cost(const Histogram &h) const override {
+			Lengths   len = lengths(h);
+			uint64_t  c = 4*256;
+			for(Size_t s=0;s<256;++s) c += uint64_t(len[s])*h.count[s];
+			return c;
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			encode(data, n, Histogram(data, n), out);
+		}
+		/// @brief codage avec un histogramme déjà calculé
+		void encode(const Byte *data, Size_t n, const Histogram &h, Stream &out) {
+			Lengths  len = lengths(h);
+			for(Size_t s=0;s<256;++s) out.write_bits(len[s], 4);
+			std::array<uint32_t, 256>  code = codes(len);
+			for(Size_t i=0;i<n;++i) out.write_bits(code[data[i]], len[data[i]]);
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			return read_table(in) && decode_symbols(in, data, n);
+		}
+		/// un code fait au moins 1 bit
+		uint64_t max_size(const Stream &in) const override {
+			const uint64_t  bits = unread(in);
+			return bits > 4*256 ? bits - 4*256 : 0;
+		}
+		/// @brief lecture de la table d'un bloc. Les symboles peuvent ensuite être décodés par
+		/// morceaux avec decode_symbols (cf Bits::symbols dans BitDecode.h).
+		bool read_table(Stream &in) {
+			if (unread(in) < 4*256) return false;
+			Lengths  len;
+			for(Size_t s=0;s<256;++s) len[s] = Byte(in.get_bits(4));
+			return table(len, tab);
+		}
+		/// décodage séquentiel de n symboles au curseur de lecture avec la table lue par read_table
+		/// (faux si un code est invalide ou dépasse la fin du flux)
+		bool decode_symbols(Stream &in, Byte *data, Size_t n) {
+			for(Size_t i=0;i<n;++i) {
+				uint16_t  e = tab[in.peek_bits(MaxLength)];
+				if ((e == 0) || (unread(in) < Size_t(e >> 8))) return false;
+				data[i] = Byte(e & 0xFF);
+				in.skip_bits(e >> 8);
+			}
+			return true;
+		}
+	protected:
+		std::vector<uint16_t>	tab;	///< table de décodage (réutilisée d'un bloc à l'autre)
+	};
+
+	/// class Bits::CLZ
+	/// codage LZ77 glouton (fenêtre de 64 Ko, correspondances de 3 à 258 octets).
+	/// format: littéral = 0 + octet (8 bits), correspondance = 1 + longueur-3 (8 bits) + distance-1 (16 bits)
+	class CLZ : public Codec {
+	public:
+		static constexpr Size_t MinMatch = 3, MaxMatch = 258, Window = 1u << 16, HashBits = 15;
+
+		uint32_t magic() const override { return Magic('C','L','Z','0'); }
+		const char *name() const override { return "LZ77"; }
+		/// le coût ne peut pas se déduire de l'histogramme: on retourne celui du pire cas (que des littéraux)
+		uint64_t cost(const Histogram &h) const override { return 9ull*h.total; }
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			head.assign(Size_t(1) << HashBits, -1);
+			Size_t  i = 0;
+			while (i < n) {
+				Size_t  best = 0, dist = 0;
+				if (i + MinMatch <= n) {
+					Size_t   h = hash(data + i);
+					int32_t  cand = head[h];
+					head[h] = int32_t(i);
+					if ((cand >= 0) && (i - Size_t(cand) <= Window)) {
+						Size_t  maxlen = std::min(Size_t(MaxMatch), n - i);
+						while ((best < maxlen) && (data[Size_t(cand) + best] == data[i + best])) ++best;
+						dist = i - Size_t(cand);
+					}
+				}
+				if (best >= MinMatch) {
+					out.write_bits(1, 1);
+					out.write_bits(best - MinMatch, 8);
+					out.write_bits(dist - 1, 16);
+					for(Size_t j=i+1;(j<i+best) && (j+MinMatch<=n);++j) head[hash(data + j)] = int32_t(j);
+					i += best;
+				} else {
+					out.write_bits(Size_t(data[i]) << 1, 9);
+					++i;
+				}
+			}
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			Size_t  i = 0;
+			while (i < n) {
+				if (in.get_bits(1)) {
+					Size_t  len = in.get_bits(8) + MinMatch, dist = in.get_bits(16) + 1;
+					if ((dist > i) || (len > n - i)) return false;
+					for(Size_t j=0;j<len;++j,++i) data[i] = data[i - dist];
+				} else {
+					data[i++] = Byte(in.get_bits(8));
+				}
+			}
+			return true;
+		}
+		/// au plus MaxMatch octets par élément de 9 bits au moins
+		uint64_t max_size(const Stream &in) const override { return (unread(in) + 8) / 9 * MaxMatch; }
+	protected:
+		std::vector<int32_t>	head;	///< dernière position vue pour chaque empreinte de 3 octets
+		static Size_t hash(const Byte *p) {
+			uint32_t  v = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+			return (v * 2654435761u) >> (32 - HashBits);
+		}
+	};
+
+	/// class Bits::CAdaptive
+	/// conteneur qui découpe les données en blocs et choisit pour chaque bloc le codeur le moins
+	/// coûteux (stockage brut, taille fixe, Huffman ou LZ77).
+	/// Le coût des trois premiers est calculé exactement à partir de l'histogramme du bloc. LZ77 est
+	/// essayé directement dans le flux (point de reprise) et annulé s'il ne fait pas mieux.
+	/// Si checksum est actif, le CRC-32C des données d'origine est calculé bloc par bloc pendant le
+	/// codage et stocké en pied. Au décodage, il est recalculé de même et comparé une seule fois, à
+	/// la fin: une erreur n'est détectée qu'après le décodage de tous les blocs.
+	/// format: taille des blocs (32 bits), présence du CRC (1 bit), puis pour chaque bloc:
+	/// codeur (2 bits) + bloc codé, puis CRC (32 bits) éventuel.
+	class CAdaptive : public Codec {
+	public:
+		/// identifiant du codeur dans l'entête de bloc
+		enum Method : Size_t { Stored = 0, FixedWidth = 1, Entropy = 2, Dictionary = 3, NbMethods = 4 };
+
+		/// @param block_size taille des blocs en octets
+		/// @param try_lz essaie LZ77 sur chaque bloc (plus lent au codage)
+		/// @param checksum ajoute le CRC-32C des données d'origine en pied
+		CAdaptive(Size_t block_size = 1u << 16, bool try_lz = true, bool checksum = false)
+			: block_size(block_size ? block_size : 1), try_lz(try_lz), checksum(checksum) {}
+
+		uint32_t magic() const override { return Magic('A','D','P','0'); }
+		const char *name() const override { return "Adaptive"; }
+		uint64_t cost(const Histogram &h) const override {
+			return 2 + std::min({stored.cost(h), ctf.cost(h), huffman.cost(h)});
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			usage.fill(0);
+			out.write_bits(block_size, 32);
+			out.write_bits(checksum, 1);
+			CRC32C  crc;
+			for(Size_t first=0;first<n;first+=block_size) {
+				const Byte	*block = data + first;
+				Size_t		size = std::min(block_size, n - first);
+				Histogram	h(block, size);
+				if (checksum) crc.update(block, size);
+				uint64_t	costs[] = { stored.cost(h), ctf.cost(h), huffman.cost(h) };
+				Size_t		best = Size_t(std::min_element(costs, costs + 3) - costs);
+				if (try_lz) {
+					Stream::Checkpoint  c = out.mark();
+					out.write_bits(Dictionary, 2);
+					lz.encode(block, size, out);
+					if (out.bits_since(c) < costs[best] + 2) {
+						out.commit(c);
+						++usage[Dictionary];
+						continue;
+					}
+					out.rollback(c);
+					out.commit(c);
+				}
+				out.write_bits(best, 2);
+				switch (best) {
+					case Stored:		stored.encode(block, size, out); break;
+					case FixedWidth:	ctf.encode(block, size, h, out); break;
+					default:			huffman.encode(block, size, h, out); break;
+				}
+				++usage[best];
+			}
+			if (checksum) out.write_bits(crc.value(), 32);
+		}
+		/// retourne aussi faux si le CRC est présent et ne correspond pas aux données décodées.
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			Size_t  bsize = in.get_bits(32);
+			bool    with_crc = in.get_bits(1);
+			CRC32C  crc;
+			if (bsize == 0) return false;
+			for(Size_t first=0;first<n;first+=bsize) {
+				Size_t  size = std::min(bsize, n - first);
+				if (!codec(in.get_bits(2)).decode(in, data + first, size)) return false;
+				if (with_crc) crc.update(data + first, size);
+			}
+			return !with_crc || (in.get_bits(32) == crc.value());
+		}
+		/// un bloc fait au moins 10 bits (codeur + un octet)
+		uint64_t max_size(const Stream &in) const override {
+			const uint64_t  bits = unread(in);
+			return bits < 33 ? 0 : (bits - 33) / 10 * uint64_t(in.peek_bits(32));
+		}
+		/// nombre de blocs codés par chaque méthode lors du dernier encode
+		const std::array<Size_t, NbMethods>& get_usage() const { return usage; }
+	protected:
+		Size_t		block_size;
+		bool		try_lz;
+		bool		checksum;
+		CStored		stored;
+		CTF			ctf;
+		CHuffman	huffman;
+		CLZ			lz;
+		std::array<Size_t, NbMethods>	usage{};
+		Codec& codec(Size_t method) {
+			switch (method) {
+				case Stored:		return stored;
+				case FixedWidth:	return ctf;
+				case Entropy:		return huffman;
+				default:			return lz;
+			}
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,219 @@
+/// library: bitstream / BitColumn.h (codage de colonnes d'entiers)
+/// + Bits::CColumn : codage de suites d'entiers (horodatages, compteurs, ...) par blocs de 128
+///   valeurs. Pour chaque bloc, choix du plus court entre:
+///   - FOR (frame of reference): écarts des valeurs au minimum du bloc,
+///   - Delta: écarts des différences x[i] - x[i-4] à leur minimum,
+///   les écarts étant ensuite écrits sur le nombre de bits minimal du bloc.
+/// + entête de bloc: mode (1 bit), largeur (7 bits), puis la référence (minimum) en zigzag, précédée
+///   de sa largeur (7 bits): quelques bits pour les petites valeurs, signées ou non.
+/// + décodage par sommes préfixes sur 4 voies indépendantes (AVX2 si disponible).
+
+#ifndef _BITCOLUMN
+#define _BITCOLUMN
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <type_traits>
+#include "BitBase.h"
+#include "BitBlock.h"
+#include "BitStream.h"
+#include "BitCodec.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BITS_COLUMN_AVX2
+#endif
+
+namespace Bits {
+	/// class Bits::CColumn
+	/// Les différences de Delta sont prises à distance 4 (x[i] - x[i-4]): le décodage est alors une
+	/// somme préfixe sur 4 voies indépendantes, qui se vectorise. Les 4 valeurs qui précèdent le
+	/// premier bloc valent 0; les blocs suivants prolongent les voies du bloc précédent, quel que soit
+	/// son mode. Différences et écarts sont calculés modulo 2^64 (arithmétique de Bits::Block<64>), le
+	/// minimum étant pris en signé pour les différences.
+	class CColumn {
+	public:
+		enum : Size_t {
+			BlockSize = 128,	///< valeurs par bloc
+			Lanes = 4			///< distance des différences de Delta
+		};
+		enum Mode : Size_t { FrameOfReference = 0, Delta = 1, NbModes };
+
+		/// magic number de l'entête écrite par compress
+		static constexpr uint32_t magic() { return Magic('C','O','L','0'); }
+
+		/// @brief code les n valeurs de data dans out (T: entier de 8 à 64 bits, signé ou non).
+		template <class T> void encode(const T *data, Size_t n, Stream &out) {
+			static_assert(std::is_integral<T>::value && (sizeof(T) <= 8), "CColumn: entiers de 64 bits au plus");
+			uint64_t  prev[Lanes] = {}, d[BlockSize];
+			for(Size_t start=0;start<n;start+=BlockSize) {
+				const Size_t  len = std::min(Size_t(BlockSize), n - start);
+				// FOR: minimum et maximum au sens du type (signé ou non)
+				T	 lo = data[start], hi = data[start];
+				for(Size_t i=1;i<len;++i) { lo = std::min(lo, data[start+i]); hi = std::max(hi, data[start+i]); }
+				const uint64_t  ref_for = widen(lo);
+				const Size_t	w_for = bit_width((Block<64>(widen(hi)) - Block<64>(ref_for)).get());
+				// Delta: x[i] - x[i-4] modulo 2^64, minimum et maximum en signé
+				for(Size_t i=0;i<len;++i) {
+					const uint64_t  before = (i < Lanes) ? prev[i] : widen(data[start+i-Lanes]);
+					d[i] = (Block<64>(widen(data[start+i])) - Block<64>(before)).get();
+				}
+				int64_t  dlo = int64_t(d[0]), dhi = int64_t(d[0]);
+				for(Size_t i=1;i<len;++i) { dlo = std::min(dlo, int64_t(d[i])); dhi = std::max(dhi, int64_t(d[i])); }
+				const uint64_t  ref_delta = uint64_t(dlo);
+				const Size_t	w_delta = bit_width((Block<64>(uint64_t(dhi)) - Block<64>(ref_delta)).get());
+				// mode le plus court (FOR à égalité: décodage plus simple)
+				const uint64_t  c_for = bit_width(zigzag(ref_for)) + uint64_t(w_for)*len;
+				const uint64_t  c_delta = bit_width(zigzag(ref_delta)) + uint64_t(w_delta)*len;
+				const Mode	  mode = (c_for <= c_delta) ? FrameOfReference : Delta;
+				const Size_t  width = (mode == FrameOfReference) ? w_for : w_delta;
+				const uint64_t  ref = (mode == FrameOfReference) ? ref_for : ref_delta;
+				out.write_bits(mode, 1);
+				out.write_bits(width, 7);
+				out.write_bits(bit_width(zigzag(ref)), 7);
+				write64(out, zigzag(ref), bit_width(zigzag(ref)));
+				if (width) {
+					if (mode == FrameOfReference)
+						for(Size_t i=0;i<len;++i) write64(out, (Block<64>(widen(data[start+i])) - Block<64>(ref)).get(), width);
+					else
+						for(Size_t i=0;i<len;++i) write64(out, (Block<64>(d[i]) - Block<64>(ref)).get(), width);
+				}
+				uint64_t  last[Lanes];	// x[start+len-Lanes .. start+len[ pour le bloc suivant
+				for(Size_t i=0;i<Lanes;++i) last[i] = (len + i >= Lanes) ? widen(data[start+len+i-Lanes]) : prev[len + i];
+				std::copy(last, last + Lanes, prev);
+				++usage[mode];
+			}
+		}
+		/// @brief décode n valeurs depuis in dans data. Retourne faux si les données sont incohérentes.
+		template <class T> bool decode(Stream &in, T *data, Size_t n) {
+			static_assert(std::is_integral<T>::value && (sizeof(T) <= 8), "CColumn: entiers de 64 bits au plus");
+			uint64_t  prev[Lanes] = {}, u[BlockSize + Lanes];
+			for(Size_t start=0;start<n;start+=BlockSize) {
+				const Size_t  len = std::min(Size_t(BlockSize), n - start);
+				if (remaining(in) < 15) return false;
+				const Mode	  mode = Mode(in.get_bits(1));
+				const Size_t  width = in.get_bits(7), wref = in.get_bits(7);
+				if ((width > 64) || (wref > 64) || (remaining(in) < wref + uint64_t(width)*len)) return false;
+				const uint64_t  ref = unzigzag(wref ? read64(in, wref) : 0);
+				unpack(in, u + Lanes, len, width);
+				if (mode == FrameOfReference) add(u + Lanes, len, ref);
+				else {
+					for(Size_t i=0;i<Lanes;++i) u[i] = prev[i];
+					prefix_sum(u, len, ref);
+				}
+				for(Size_t i=0;i<len;++i) data[start+i] = T(u[Lanes+i]);
+				uint64_t  last[Lanes];	// x[start+len-Lanes .. start+len[ pour le bloc suivant
+				for(Size_t i=0;i<Lanes;++i) last[i] = (len + i >= Lanes) ? u[len + i] : prev[len + i];
+				std::copy(last, last + Lanes, prev);
+				++usage[mode];
+			}
+			return true;
+		}
+
+		/// @brief compression complète: magic number, nombre de valeurs (32 bits), puis blocs.
+		template <class T> void compress(const std::vector<T> &in, Stream &out) {
+			Stats::ScopedTimer  timer(Stats::EncodeCalls, Stats::EncodeNanoseconds);
+			out.write_bits(magic(), 32);
+			out.write_bits(Size_t(in.size()), 32);
+			encode(in.data(), Size_t(in.size()), out);
+		}
+		/// @brief décompression complète (relecture de l'entête à partir du curseur de lecture).
+		template <class T> bool decompress(Stream &in, std::vector<T> &out) {
+			Stats::ScopedTimer  timer(Stats::DecodeCalls, Stats::DecodeNanoseconds);
+			if ((remaining(in) < 64) || (in.get_bits(32) != magic())) return false;
+			// avant l'allocation: chaque bloc de BlockSize valeurs a une entête d'au moins 15 bits
+			const Size_t  n = in.get_bits(32);
+			if (n > remaining(in) / 15 * BlockSize) return false;
+			out.resize(n);
+			return decode(in, out.data(), n);
+		}
+
+		/// nombre de blocs codés/décodés par mode depuis la construction
+		const std::array<Size_t, NbModes>& get_usage() const { return usage; }
+
+	protected:
+		std::array<Size_t, NbModes>  usage {};
+
+		/// valeur sur 64 bits (extension du signe pour les types signés)
+		template <class T> static inline uint64_t widen(T x) {
+			return std::is_signed<T>::value ? uint64_t(int64_t(x)) : uint64_t(x);
+		}
+		/// zigzag: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+		static inline uint64_t zigzag(uint64_t d) { return (d << 1) ^ (0 - (d >> 63)); }
+		static inline uint64_t unzigzag(uint64_t z) { return (z >> 1) ^ (0 - (z & 1)); }
+		static inline uint64_t remaining(const Stream &in) {
+			return in.get_bit_size() - in.getReadPosition().LastBit();
+		}
+		/// nombre de bits nécessaires pour écrire x (0 pour x = 0)
+		static inline Size_t bit_width(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+			return x ? Size_t(64 - __builtin_clzll(x)) : 0;
+#else
+			return MSB(x);
+#endif
+		}
+		static inline void write64(Stream &out, uint64_t v, Size_t width) {
+			if (width <= Stream::storage_unit_size) out.write_bits(Stream::storage_type(v), width);
+			else {
+				out.write_bits(Stream::storage_type(v), Stream::storage_unit_size);
+				out.write_bits(Stream::storage_type(v >> Stream::storage_unit_size), width - Stream::storage_unit_size);
+			}
+		}
+		static inline uint64_t read64(Stream &in, Size_t width) {
+			if (width <= Stream::storage_unit_size) return in.get_bits(width);
+			uint64_t  v = in.get_bits(Stream::storage_unit_size);
+			return v | (uint64_t(in.get_bits(width - Stream::storage_unit_size)) << Stream::storage_unit_size);
+		}
+		/// lecture de n valeurs de width bits: directement dans les mots du flux lorsque les trois mots
+		/// lus pour chaque valeur sont dans les données écrites, par get_bits sinon (fin du flux).
+		static void unpack(Stream &in, uint64_t *u, Size_t n, Size_t width) {
+			if (width == 0) { std::fill(u, u + n, uint64_t(0)); return; }
+			const Size_t  start = in.getReadPosition().LastBit(), end = start + n*width;
+			if (uint64_t(end) + 64 <= in.get_bit_size()) {
+				const Stream::storage_type  *w = in.get_data();
+				const uint64_t  m = (width == 64) ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+				for(Size_t i=0, p=start;i<n;++i, p+=width) {
+					const Size_t  k = p / 32, o = p % 32;
+					uint64_t  v = (uint64_t(w[k]) | (uint64_t(w[k+1]) << 32)) >> o;
+					if (o + width > 64) v |= uint64_t(w[k+2]) << (64 - o);
+					u[i] = v & m;
+				}
+				in.skip_bits(n*width);
+			}
+			else for(Size_t i=0;i<n;++i) u[i] = read64(in, width);
+		}
+		static inline void add(uint64_t *u, Size_t n, uint64_t ref) {
+			for(Size_t i=0;i<n;++i) u[i] += ref;
+		}
+		/// u[i] += ref + u[i-Lanes] pour i dans [Lanes+from, Lanes+n[ (u[0..Lanes[ = valeurs précédentes)
+		static inline void prefix_sum_scalar(uint64_t *u, Size_t from, Size_t n, uint64_t ref) {
+			for(Size_t i=Lanes+from;i<Lanes+n;++i) u[i] += ref + u[i-Lanes];
+		}
+#ifdef BITS_COLUMN_AVX2
+		__attribute__((target("avx2")))
+		static void prefix_sum_avx2(uint64_t *u, Size_t n, uint64_t ref) {
+			const __m256i  r = _mm256_set1_epi64x(int64_t(ref));
+			__m256i  acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u));
+			Size_t	 i = 0;
+			for(;i + Lanes <= n;i += Lanes) {
+				__m256i  *p = reinterpret_cast<__m256i*>(u + Lanes + i);
+				acc = _mm256_add_epi64(acc, _mm256_add_epi64(_mm256_loadu_si256(p), r));
+				_mm256_storeu_si256(p, acc);
+			}
+			prefix_sum_scalar(u, i, n, ref);
+		}
+		static bool has_avx2() {
+			static const bool  avx2 = __builtin_cpu_supports("avx2");
+			return avx2;
+		}
+#endif
+		static inline void prefix_sum(uint64_t *u, Size_t n, uint64_t ref) {
+#ifdef BITS_COLUMN_AVX2
+			if (has_avx2()) { prefix_sum_avx2(u, n, ref); return; }
+#endif
+			prefix_sum_scalar(u, 0, n, ref);
+		}
+	};
+}
+
+#endif
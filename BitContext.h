@@ -0,0 +1,299 @@
+/// library: bitstream / BitContext.h (modélisation par contextes et codage arithmétique binaire)
+/// + Bits::RangeEncoder, Bits::RangeDecoder : codeur arithmétique binaire (probabilités sur 12 bits)
+///   écrivant/lisant ses octets dans un Bits::Stream.
+/// + Bits::ContextModel : modèle adaptatif d'ordre 1 et/ou 2. Chaque octet est codé bit à bit, la
+///   probabilité de chaque bit étant prédite par les octets précédents; avec le mélange, les deux
+///   ordres sont combinés par un mélangeur logistique qui apprend leurs poids.
+/// + Bits::CContext : codeur (format de Bits::Codec) utilisant le modèle et le codeur arithmétique.
+
+#ifndef _BITCONTEXT
+#define _BITCONTEXT
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitCodec.h"
+
+namespace Bits {
+	/// class Bits::RangeEncoder
+	/// intervalle [x1,x2] sur 32 bits, coupé proportionnellement à la probabilité du bit 1; les
+	/// octets de poids fort communs à x1 et x2 sont définitifs et écrits aussitôt.
+	class RangeEncoder {
+	public:
+		explicit RangeEncoder(Stream &out) : out(out) {}
+		/// @brief code bit, p1 étant la probabilité (sur 12 bits, dans [1,4095]) qu'il vaille 1.
+		inline void encode(Size_t bit, Size_t p1) {
+			const uint32_t  xmid = x1 + ((x2 - x1) >> 12) * p1, m = 0u - uint32_t(bit);
+			// sans branchement: le bit est imprévisible
+			x2 = (xmid & m) | (x2 & ~m);
+			x1 = (x1 & m) | ((xmid + 1) & ~m);
+			while (((x1 ^ x2) & 0xFF000000u) == 0) {
+				out.write_bits(x2 >> 24, 8);
+				x1 <<= 8;
+				x2 = (x2 << 8) | 0xFF;
+			}
+		}
+		/// @brief termine le codage (4 octets: le décodeur lit exactement ce qui a été écrit).
+		inline void flush() {
+			for(Size_t i=0;i<4;++i, x1 <<= 8) out.write_bits(x1 >> 24, 8);
+			x1 = 0; x2 = 0xFFFFFFFFu;
+		}
+	protected:
+		Stream		&out;
+		uint32_t	x1 = 0, x2 = 0xFFFFFFFFu;
+	};
+
+	/// class Bits::RangeDecoder
+	/// relit le codage de Bits::RangeEncoder à partir du curseur de lecture du flux (qui avance).
+	class RangeDecoder {
+	public:
+		explicit RangeDecoder(Stream &in) : in(in) {
+			for(Size_t i=0;i<4;++i) x = (x << 8) | next();
+		}
+		/// @brief décode un bit de probabilité p1 (la même qu'au codage).
+		inline Size_t decode(Size_t p1) {
+			const uint32_t  xmid = x1 + ((x2 - x1) >> 12) * p1;
+			const Size_t    bit = (x <= xmid);
+			const uint32_t  m = 0u - uint32_t(bit);
+			x2 = (xmid & m) | (x2 & ~m);
+			x1 = (x1 & m) | ((xmid + 1) & ~m);
+			while (((x1 ^ x2) & 0xFF000000u) == 0) {
+				x1 <<= 8;
+				x2 = (x2 << 8) | 0xFF;
+				x = (x << 8) | next();
+			}
+			return bit;
+		}
+		/// faux si le décodage a lu au-delà des données du flux
+		inline bool valid() const { return !overrun; }
+	protected:
+		Stream		&in;
+		uint32_t	x1 = 0, x2 = 0xFFFFFFFFu, x = 0;
+		bool		overrun = false;
+		inline uint32_t next() {
+			if (in.get_bit_size() - in.getReadPosition().LastBit() < 8) { overrun = true; return 0; }
+			return in.get_bits(8);
+		}
+	};
+
+	/// class Bits::ContextModel
+	/// Les 8 bits d'un octet sont prédits l'un après l'autre (poids fort en premier), par quartet: pour
+	/// chaque quartet et chaque ordre, le contexte (octets précédents, premier quartet si c'est le second)
+	/// désigne une case de 16 compteurs de 32 bits, soit une ligne de cache, dans laquelle les 15 noeuds de
+	/// l'arbre binaire du quartet sont rangés. L'ordre 1 est indexé directement (256 x 17 cases), l'ordre
+	/// 2 par hachage; le compteur 0 de chaque case d'ordre 2 contient alors le hachage du contexte, et la
+	/// case est réinitialisée si un autre contexte l'occupait.
+	/// Compteur: probabilité du bit 1 sur 22 bits et nombre n d'observations sur 10 bits. La probabilité
+	/// se rapproche du bit observé de 1/(n + 1.5): moyenne exacte au début, puis n est plafonné à Limit
+	/// (remise à l'échelle: les observations anciennes perdent alors leur poids au profit des récentes).
+	/// Mélange: p = squash(w1 st(p1) + w2 st(p2) + w0), st = log(p/(1-p)), poids choisis par les bits
+	/// déjà connus de l'octet et corrigés après chaque bit dans le sens de l'erreur de prédiction.
+	class ContextModel {
+	public:
+		enum Constants : Size_t {
+			MinHashBits = 12,	///< nombre minimal de bits de la table d'ordre 2 (en cases)
+			MaxHashBits = 18,	///< nombre maximal (2^18 cases de 64 octets, 16 Mo)
+			Limit = 255,		///< plafond du nombre d'observations d'un compteur
+			LearningRate = 6	///< vitesse d'apprentissage du mélangeur
+		};
+
+		ContextModel(const ContextModel&) = delete;
+		ContextModel& operator=(const ContextModel&) = delete;
+		/// @param order ordre du modèle (1 ou 2)
+		/// @param mix mélange des ordres 1 et 2 (ignoré à l'ordre 1)
+		/// @param hash_bits log2 du nombre de cases de la table d'ordre 2
+		ContextModel(Size_t order, bool mix, Size_t hash_bits)
+			: t(tables()), order(order), mix(mix && (order == 2)), hash_bits(hash_bits) {
+			BITS_ASSERT( (order >= 1) && (order <= 2) && "ContextModel: ordre 1 ou 2");
+			BITS_ASSERT( (hash_bits >= MinHashBits) && (hash_bits <= MaxHashBits) && "ContextModel: table d'ordre 2 invalide");
+			if ((order == 1) || mix) o1.assign(256*17);
+			if (order == 2) o2.assign(size_t(1) << hash_bits);
+			for(Size_t c=0;c<256;++c) {
+				weights[c][0] = 0;
+				weights[c][1] = weights[c][2] = 1 << 15;
+			}
+			select();
+		}
+
+		/// @brief probabilité (sur 12 bits, dans [1,4095]) que le prochain bit vaille 1.
+		inline Size_t p() {
+			if (!mix) return clamp(Size_t(*(order == 1 ? e1 : e2) >> 20));
+			s1 = t.stretch[*e1 >> 20];
+			s2 = t.stretch[*e2 >> 20];
+			const int  *w = weights[c0];
+			int64_t  dot = (int64_t(w[0]) * 256 + int64_t(w[1]) * s1 + int64_t(w[2]) * s2) >> 16;
+			dot = std::max(int64_t(-2047), std::min(int64_t(2047), dot));
+			pr = t.squash[dot + 2048];
+			return pr;
+		}
+		/// @brief mise à jour après le codage du bit dont la probabilité vient d'être demandée.
+		inline void update(Size_t bit) {
+			if (mix) {
+				const int  err = (int(bit << 12) - int(pr)) * int(LearningRate);
+				int		   *w = weights[c0];
+				w[0] += (256 * err) >> 14;
+				w[1] += (s1 * err) >> 14;
+				w[2] += (s2 * err) >> 14;
+			}
+			if (e1) train(*e1, bit);
+			if (e2) train(*e2, bit);
+			c0 = (c0 << 1) | bit;
+			node = (node << 1) | bit;
+			if (c0 >= 256) {
+				history = (history << 8) | (c0 & 0xFF);
+				c0 = 1;
+				select();
+			} else if (node >= 16) select();
+			else point();
+		}
+
+	protected:
+		/// cases de 16 compteurs alignées sur les lignes de cache (alignement fait à la main: std::vector
+		/// n'aligne pas au-delà de alignof(max_align_t) avant C++17)
+		struct Slots {
+			std::vector<uint32_t>	memory;
+			uint32_t				*base = nullptr;
+			void assign(size_t n) {
+				memory.assign(16*n + 15, 1u << 31);
+				base = memory.data() + (16 - (reinterpret_cast<uintptr_t>(memory.data()) / sizeof(uint32_t)) % 16) % 16;
+				for(size_t k=0;k<n;++k) base[16*k] = 0;
+			}
+			inline uint32_t* operator[](size_t k) const { return base + 16*k; }
+			inline bool empty() const { return base == nullptr; }
+		};
+		/// tables de st (4096 probabilités) et de sa réciproque squash (st dans [-2047,2047]),
+		/// inverses 16384/(2n+3) des vitesses d'adaptation des compteurs
+		struct Tables {
+			int16_t		stretch[4096];
+			uint16_t	squash[4096];
+			int32_t		reciprocal[1024];
+			Tables() {
+				for(int p=0;p<4096;++p) {
+					const double  s = 256*std::log((p + 0.5) / (4095.5 - p));
+					stretch[p] = int16_t(std::max(-2047.0, std::min(2047.0, std::round(s))));
+				}
+				for(int d=-2047;d<=2047;++d) {
+					const double  q = 4096 / (1 + std::exp(-d / 256.0));
+					squash[d + 2048] = uint16_t(std::max(1.0, std::min(4095.0, std::round(q))));
+				}
+				for(int n=0;n<1024;++n) reciprocal[n] = 16384 / (2*n + 3);
+			}
+		};
+		static const Tables& tables() {
+			static const Tables  t;
+			return t;
+		}
+
+		const Tables		&t;
+		Size_t				order;
+		bool				mix;
+		Size_t				hash_bits;
+		Slots				o1, o2;
+		int					weights[256][3];
+		uint32_t			history = 0;		///< octets précédents (le dernier en poids faible)
+		Size_t				c0 = 1;				///< bits connus de l'octet courant, précédés d'un 1
+		Size_t				node = 1;			///< noeud dans le quartet courant (1 à 15)
+		uint32_t			*slot1 = nullptr, *slot2 = nullptr;
+		uint32_t			*e1 = nullptr, *e2 = nullptr;
+		int					s1 = 0, s2 = 0;
+		Size_t				pr = 2048;
+
+		static inline Size_t clamp(Size_t p) { return std::max(Size_t(1), std::min(Size_t(4095), p)); }
+		/// mise à jour d'un compteur (cf description de la classe)
+		inline void train(uint32_t &e, Size_t bit) const {
+			const Size_t  n = e & 1023;
+			const int32_t p = int32_t(e >> 10);
+			if (n < Limit) ++e;
+			const int64_t  d = (int64_t(int32_t(bit << 22) - p) * t.reciprocal[n]) >> 3;
+			e += uint32_t(d) & 0xFFFFFC00u;
+		}
+		/// cases des contextes du quartet qui commence (premier quartet si c0 = 1)
+		inline void select() {
+			const Size_t  nibble = (c0 == 1) ? 0 : 1 + (c0 & 15);
+			if (!o1.empty()) slot1 = o1[((history & 0xFF) * 17) + nibble];
+			if (!o2.empty()) {
+				const uint32_t  h = (((history & 0xFFFF) * 17 + nibble) * 2654435761u) ^ 0x9E3779B9u;
+				slot2 = o2[h >> (32 - hash_bits)];
+				if (slot2[0] != h) {
+					slot2[0] = h;
+					for(Size_t i=1;i<16;++i) slot2[i] = 1u << 31;
+				}
+			}
+			node = 1;
+			point();
+		}
+		/// compteurs du noeud courant
+		inline void point() {
+			if (slot1) e1 = slot1 + node;
+			if (slot2) e2 = slot2 + node;
+		}
+	};
+
+	/// class Bits::CContext
+	/// format: ordre (2 bits), mélange (1 bit), log2 de la table d'ordre 2 (5 bits), puis le codage
+	/// arithmétique des octets. La table d'ordre 2 est dimensionnée d'après la taille du bloc.
+	class CContext : public Codec {
+	public:
+		/// @param order ordre du modèle (1 ou 2)
+		/// @param mix mélange des ordres 1 et 2 (si order = 2)
+		explicit CContext(Size_t order = 2, bool mix = true) : order(std::max(Size_t(1), std::min(Size_t(2), order))), mix(mix) {}
+
+		uint32_t magic() const override { return Magic('C','T','X','0'); }
+		const char *name() const override { return "Context"; }
+		/// le gain des contextes ne se déduit pas de l'histogramme: entropie d'ordre 0 (majorant usuel)
+		uint64_t cost(const Histogram &h) const override {
+			double  bits = 0;
+			for(Size_t s=0;s<256;++s)
+				if (h.count[s]) bits -= h.count[s] * std::log2(double(h.count[s]) / h.total);
+			return 8 + 32 + uint64_t(bits);
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			const Size_t  hb = hash_bits(n);
+			out.write_bits(order, 2);
+			out.write_bits(mix, 1);
+			out.write_bits(hb, 5);
+			ContextModel  model(order, mix, hb);
+			RangeEncoder  coder(out);
+			for(Size_t i=0;i<n;++i)
+				for(Size_t k=8;k-->0;) {
+					const Size_t  bit = (data[i] >> k) & 1;
+					coder.encode(bit, model.p());
+					model.update(bit);
+				}
+			coder.flush();
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			const Size_t  o = in.get_bits(2), m = in.get_bits(1), hb = in.get_bits(5);
+			if ((o < 1) || (o > 2) || (hb < ContextModel::MinHashBits) || (hb > ContextModel::MaxHashBits)) return false;
+			ContextModel  model(o, m != 0, hb);
+			RangeDecoder  coder(in);
+			for(Size_t i=0;i<n;++i) {
+				Size_t  c = 0;
+				for(Size_t k=0;k<8;++k) {
+					const Size_t  bit = coder.decode(model.p());
+					model.update(bit);
+					c = (c << 1) | bit;
+				}
+				data[i] = Byte(c);
+				if (!coder.valid()) return false;
+			}
+			return true;
+		}
+		/// probabilités plafonnées à 4095/4096: un bit codé coûte au moins log2(4096/4095) bits,
+		/// soit au plus 355 octets décodés par bit lu (après l'entête de 8 bits)
+		uint64_t max_size(const Stream &in) const override {
+			const uint64_t  bits = unread(in);
+			return bits < 8 ? 0 : (bits - 8) * 355;
+		}
+	protected:
+		Size_t	order;
+		bool	mix;
+		/// table d'ordre 2: environ une case par octet du bloc
+		static Size_t hash_bits(Size_t n) {
+			return std::max(Size_t(ContextModel::MinHashBits), std::min(Size_t(ContextModel::MaxHashBits), MSB(n) - (n > 1)));
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,169 @@
+/// library: bitstream / BitDecode.h (décodage paresseux)
+/// + Bits::Decoded<T, Source> : suite de valeurs décodées à la demande, parcourue par for(auto x : ...)
+///   ou par next(x), sans recopie préalable de toute la suite dans un std::vector.
+/// + le décodage se fait par paquets de Batch valeurs (tampon interne), qui restent en cache pendant
+///   leur traitement par l'appelant.
+/// + Bits::blocks<N>(stream) : valeurs de Block<N> (lecture par mots de 32 bits, cf BitRecord.h),
+///   Bits::symbols(huffman, stream, n) : symboles d'un bloc Bits::CHuffman,
+///   Bits::decoded<T>(f) : suite produite par une fonction de décodage quelconque.
+
+#ifndef _BITDECODE
+#define _BITDECODE
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitCodec.h"
+#include "BitRecord.h"
+
+namespace Bits {
+	/// class Bits::Decoded
+	/// Source est un objet fonction: source(T *out, Size_t max) décode au plus max valeurs dans out et
+	/// retourne leur nombre (0 en fin de suite); source.valid() est faux si le décodage a échoué.
+	/// La suite ne se parcourt qu'une fois (itérateur d'entrée) et le flux décodé ne doit pas être
+	/// utilisé pendant le parcours: son curseur de lecture peut être en avance d'un paquet.
+	template <class T, class Source> class Decoded {
+	public:
+		using value_type = T;
+		static constexpr Size_t Batch = 256;
+
+		/// itérateur d'entrée: operator++ décode le paquet suivant quand le tampon est épuisé
+		class iterator {
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = const T&;
+
+			iterator() = default;
+			inline const T& operator*() const { return d->buffer[d->pos]; }
+			inline iterator& operator++() {
+				if (++d->pos == d->count) d->refill();
+				return *this;
+			}
+			/// seuls sont comparables un itérateur et la fin de la suite
+			friend bool operator==(const iterator &a, const iterator &b) { return a.done() == b.done(); }
+			friend bool operator!=(const iterator &a, const iterator &b) { return a.done() != b.done(); }
+
+		protected:
+			Decoded  *d = nullptr;
+			explicit iterator(Decoded *d) : d(d) {}
+			inline bool done() const { return !d || (d->pos >= d->count); }
+			friend class Decoded;
+		};
+
+		explicit Decoded(Source source) : source(std::move(source)) {}
+
+		/// début du parcours (au point où en est la suite si elle a déjà été entamée)
+		iterator begin() {
+			if (pos == count) refill();
+			return iterator(this);
+		}
+		iterator end() { return iterator(); }
+		/// @brief valeur suivante. Retourne faux en fin de suite.
+		inline bool next(T &v) {
+			if ((pos == count) && !refill()) return false;
+			v = buffer[pos++];
+			return true;
+		}
+		/// faux si le décodage a échoué (la suite s'arrête alors au dernier paquet valide)
+		inline bool valid() const { return source.valid(); }
+
+	protected:
+		Source	source;
+		T		buffer[Batch];	///< paquet courant
+		Size_t	pos = 0;		///< prochaine valeur de buffer
+		Size_t	count = 0;		///< nombre de valeurs de buffer
+
+		inline bool refill() {
+			pos = 0;
+			count = source(buffer, Batch);
+			return count != 0;
+		}
+	};
+
+	/// class Bits::BlockSource
+	/// valeurs successives de Block<NBITS> (format de stream << Block<NBITS>(v)), lues par Bits::BitUnpacker.
+	/// Lit n valeurs, ou toutes les valeurs complètes jusqu'à la fin du flux si n = All.
+	template <int NBITS> class BlockSource {
+	public:
+		using Type = typename Block<NBITS>::Type;
+		static constexpr uint64_t All = ~uint64_t(0);
+
+		BlockSource(Stream &in, uint64_t n) : in(in), remaining(n) {}
+		Size_t operator()(Type *out, Size_t max) {
+			const uint64_t  wanted = std::min(uint64_t(max), remaining),
+							avail = uint64_t(in.get_bit_size() - in.getReadPosition().LastBit()) / Size_t(NBITS);
+			if ((avail < wanted) && (remaining != All)) ok = false;
+			const Size_t  k = Size_t(std::min(wanted, avail));
+			BitUnpacker  u(in);
+			for(Size_t i=0;i<k;++i) out[i] = Type(u.get(Size_t(NBITS)));
+			if (remaining != All) remaining = ok ? remaining - k : 0;
+			return k;
+		}
+		inline bool valid() const { return ok; }
+
+	protected:
+		Stream		&in;
+		uint64_t	remaining;
+		bool		ok = true;
+	};
+
+	/// class Bits::HuffmanSource
+	/// n symboles d'un bloc Bits::CHuffman (table comprise), décodés par paquets avec la table du codeur.
+	class HuffmanSource {
+	public:
+		HuffmanSource(CHuffman &codec, Stream &in, Size_t n) : codec(codec), in(in), remaining(n), ok(codec.read_table(in)) {
+			if (!ok) remaining = 0;
+		}
+		Size_t operator()(Byte *out, Size_t max) {
+			const Size_t  k = std::min(max, remaining);
+			if (!codec.decode_symbols(in, out, k)) {
+				ok = false;
+				remaining = 0;
+				return 0;
+			}
+			remaining -= k;
+			return k;
+		}
+		inline bool valid() const { return ok; }
+
+	protected:
+		CHuffman	&codec;
+		Stream		&in;
+		Size_t		remaining;
+		bool		ok;
+	};
+
+	/// class Bits::FunctionSource
+	/// adaptateur d'un objet fonction f(T *out, Size_t max) -> nombre de valeurs produites (toujours valide)
+	template <class F> class FunctionSource {
+	public:
+		explicit FunctionSource(F f) : f(std::move(f)) {}
+		template <class T> inline Size_t operator()(T *out, Size_t max) { return f(out, max); }
+		inline bool valid() const { return true; }
+	protected:
+		F  f;
+	};
+
+	/// @brief valeurs de Block<NBITS> lues à partir du curseur de lecture de in: n valeurs, ou toutes
+	/// les valeurs complètes du flux (par défaut).
+	template <int NBITS> inline Decoded<typename Block<NBITS>::Type, BlockSource<NBITS>>
+		blocks(Stream &in, uint64_t n = BlockSource<NBITS>::All) {
+		return Decoded<typename Block<NBITS>::Type, BlockSource<NBITS>>(BlockSource<NBITS>(in, n));
+	}
+	/// @brief n symboles d'un bloc Bits::CHuffman lu à partir du curseur de lecture de in (codec doit
+	/// survivre au parcours). valid() est faux si la table ou un code est invalide.
+	inline Decoded<Byte, HuffmanSource> symbols(CHuffman &codec, Stream &in, Size_t n) {
+		return Decoded<Byte, HuffmanSource>(HuffmanSource(codec, in, n));
+	}
+	/// @brief suite de valeurs de type T produites par paquets par f(T *out, Size_t max).
+	template <class T, class F> inline Decoded<T, FunctionSource<F>> decoded(F f) {
+		return Decoded<T, FunctionSource<F>>(FunctionSource<F>(std::move(f)));
+	}
+}
+
+#endif
@@ -0,0 +1,155 @@
+/// library: bitstream / BitDump.h (affichage rapide de grands flux)
+/// + Bits::Dumper : affichage en binaire ou en hexadécimal d'un intervalle de bits [from, to[ d'un
+///   tableau de mots (en particulier les données d'un Bits::Stream), avec regroupement des chiffres,
+///   retour à la ligne et position de début de ligne.
+/// + les chiffres sont produits octet par octet par tables de correspondance dans un tampon
+///   réutilisable, envoyé au flux de sortie par gros morceaux (ostream::write).
+/// + l'ordre d'affichage est celui du flux: premier bit écrit en premier en binaire; en
+///   hexadécimal, chaque octet (8 bits consécutifs, le premier étant le LSB) est affiché comme
+///   dans un fichier sauvegardé (poids fort en premier).
+
+#ifndef _BITDUMP
+#define _BITDUMP
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "BitBase.h"
+
+namespace Bits {
+	/// format d'affichage
+	struct DumpFormat {
+		enum Base { Bin, Hex };
+		Base	base = Bin;		///< binaire ou hexadécimal
+		Size_t	group = 0;		///< bits par groupe, séparés par un espace (0 = pas de groupe)
+		Size_t	line = 0;		///< bits par ligne (0 = tout sur une ligne, sans retour final)
+		bool	offsets = false;///< position (en bits, hexadécimal) au début de chaque ligne
+		DumpFormat() = default;
+		DumpFormat(Base base, Size_t group = 0, Size_t line = 0, bool offsets = false)
+			: base(base), group(group), line(line), offsets(offsets) {}
+	};
+
+	/// class Bits::Dumper
+	/// Le tampon est conservé d'un appel à l'autre: un même Dumper peut afficher de nombreux flux
+	/// sans réallocation. En hexadécimal, group et line sont arrondis au multiple de 8 supérieur, et
+	/// un dernier octet incomplet est complété par des 0.
+	class Dumper {
+	public:
+		/// taille des morceaux envoyés au flux de sortie
+		static constexpr size_t ChunkSize = size_t(1) << 16;
+
+		explicit Dumper(const DumpFormat &format = DumpFormat())
+			: format(format), buffer(ChunkSize + Margin) {}
+
+		/// change le format
+		inline void set_format(const DumpFormat &f) { format = f; }
+		inline const DumpFormat& get_format() const { return format; }
+
+		/// @brief affiche les bits [from, to[ du tableau array de size éléments.
+		/// @detail le bit i est le bit i%W de array[i/W] (W = 8*sizeof(T)); to est borné à size*W.
+		template <class T> void write(std::ostream &os, const T *array, size_t size, size_t from, size_t to) {
+			static_assert(std::is_unsigned<T>::value, "Dumper: mots non signés uniquement");
+			const size_t  W = 8*sizeof(T);
+			to = std::min(to, size * W);
+			if (from >= to) return;
+			Size_t	group = format.group, line = format.line;
+			const bool  hex = (format.base == DumpFormat::Hex);
+			if (hex) { group = round8(group); line = round8(line); }
+			out = buffer.data();
+			end = out + ChunkSize;
+			size_t  ingroup = 0, inline_ = 0;	// bits déjà affichés dans le groupe et la ligne courants
+			if (format.offsets) put_offset(from);
+			// octets complets: un accès aux tables par octet, limites de groupe/ligne entre octets
+			// (toujours le cas en hexadécimal, en binaire si group et line sont multiples de 8)
+			const bool  bytewise = hex || (((group % 8) == 0) && ((line % 8) == 0));
+			size_t  pos = from;
+			if (bytewise) {
+				const Tables  &tab = tables();
+				for(;pos + 8 <= to;pos += 8) {
+					separate(ingroup, inline_, group, line, pos, pos == from);
+					const unsigned  b = byte_at(array, size, pos);
+					if (hex) { memcpy(out, tab.hex[b], 2); out += 2; }
+					else { memcpy(out, tab.bin[b], 8); out += 8; }
+					ingroup += 8;
+					inline_ += 8;
+					if (out >= end) flush(os);
+				}
+				if (hex && (pos < to)) {	// dernier octet incomplet, complété par des 0
+					separate(ingroup, inline_, group, line, pos, pos == from);
+					unsigned  b = byte_at(array, size, pos) & ((1u << (to - pos)) - 1);
+					memcpy(out, tab.hex[b], 2);
+					out += 2;
+					pos = to;
+				}
+			}
+			// bit par bit: bits restants ou groupes/lignes non multiples de 8
+			for(;pos < to;++pos) {
+				separate(ingroup, inline_, group, line, pos, pos == from);
+				*out++ = char('0' + ((array[pos / W] >> (pos % W)) & 1u));
+				++ingroup;
+				++inline_;
+				if (out >= end) flush(os);
+			}
+			if (line) *out++ = '\n';
+			flush(os);
+		}
+
+	protected:
+		/// marge du tampon au-delà de ChunkSize (un octet, un séparateur et une position au plus)
+		static constexpr size_t Margin = 64;
+		/// tables: 8 caractères binaires et 2 caractères hexadécimaux par valeur d'octet
+		struct Tables {
+			char	bin[256][8];
+			char	hex[256][2];
+			Tables() {
+				const char  *digits = "0123456789abcdef";
+				for(unsigned b=0;b<256;++b) {
+					for(unsigned i=0;i<8;++i) bin[b][i] = char('0' + ((b >> i) & 1u));
+					hex[b][0] = digits[b >> 4];
+					hex[b][1] = digits[b & 15];
+				}
+			}
+		};
+		static const Tables& tables() { static const Tables  tab; return tab; }
+
+		DumpFormat			format;
+		std::vector<char>	buffer;		///< tampon de sortie réutilisé
+		char				*out = nullptr, *end = nullptr;
+
+		static inline Size_t round8(Size_t n) { return (n + 7) & ~Size_t(7); }
+
+		/// 8 bits à partir de pos (le premier est le LSB); les bits au-delà du tableau valent 0
+		template <class T> static inline unsigned byte_at(const T *array, size_t size, size_t pos) {
+			const size_t  W = 8*sizeof(T), k = pos / W, s = pos % W;
+			uint64_t  v = uint64_t(array[k]) >> s;
+			if ((s + 8 > W) && (k + 1 < size)) v |= uint64_t(array[k+1]) << (W - s);
+			return unsigned(v & 0xFF);
+		}
+		/// séparateur avant le bit pos: retour à la ligne (et position) ou espace entre groupes
+		inline void separate(size_t &ingroup, size_t &inline_, Size_t group, Size_t line, size_t pos, bool first) {
+			if (first) return;
+			if (line && (inline_ == line)) {
+				*out++ = '\n';
+				if (format.offsets) put_offset(pos);
+				inline_ = ingroup = 0;
+			}
+			else if (group && (ingroup == group)) {
+				*out++ = ' ';
+				ingroup = 0;
+			}
+		}
+		inline void put_offset(size_t pos) {
+			const Tables  &tab = tables();
+			const uint64_t  p = pos;
+			for(int i=(p >> 32) ? 56 : 24;i>=0;i-=8) { memcpy(out, tab.hex[(p >> i) & 0xFF], 2); out += 2; }
+			*out++ = ':';
+			*out++ = ' ';
+		}
+		inline void flush(std::ostream &os) {
+			os.write(buffer.data(), std::streamsize(out - buffer.data()));
+			out = buffer.data();
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,209 @@
+/// library: bitstream / BitEliasFano.h (codage d'Elias-Fano de suites croissantes)
+/// + Bits::EliasFano : codage d'une suite croissante d'entiers (listes d'identifiants triés, listes
+///   de postings) sur 2 + log2(u/n) bits par valeur environ, u étant la plus grande valeur.
+/// + bits de poids faible (L bits) compactés dans un Bits::varPackedVector, bits de poids fort codés
+///   en unaire dans un Bits::Stream indexé par un Bits::RankSelect.
+/// + parcours séquentiel (itérateur), access(i) et next_geq(x) (premier élément >= x) en temps
+///   quasi constant, sans décodage de ce qui précède.
+/// + écriture/relecture dans un flux.
+
+#ifndef _BITELIASFANO
+#define _BITELIASFANO
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitPacked.h"
+#include "BitRank.h"
+
+namespace Bits {
+	/// class Bits::EliasFano
+	/// La valeur v d'indice i est coupée en low = v & (2^L - 1), rangé à l'indice i de lows, et
+	/// high = v >> L, codé par le bit à 1 de position high + i dans highs: le 0 de rang h sépare les
+	/// valeurs de high <= h des suivantes. Ainsi access(i) = select1(i) - i, et les valeurs >= x
+	/// commencent juste après le 0 de rang (x >> L) - 1.
+	/// highs est complété par des 0 jusqu'à un multiple de 64 bits, de sorte que le parcours peut lire
+	/// ses mots par 64 bits sans test de fin.
+	class EliasFano {
+	public:
+		using value_type = uint64_t;
+
+		/// itérateur constant, qui décode les valeurs l'une après l'autre
+		class const_iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = uint64_t;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const uint64_t*;
+			using reference = uint64_t;
+
+			const_iterator() = default;
+			/// valeur courante et son indice dans la suite
+			inline uint64_t operator*() const { return ef->value(i, pos); }
+			inline Size_t index() const { return i; }
+			inline const_iterator& operator++() {
+				if (++i < ef->count) pos = ef->next_one(pos + 1);
+				return *this;
+			}
+			inline const_iterator operator++(int) { const_iterator  t(*this); ++(*this); return t; }
+			/// @brief avance jusqu'au premier élément >= x (sans effet si l'élément courant convient).
+			/// @detail parcours si x est dans le même paquet de poids fort, saut par select0 sinon.
+			const_iterator& skip_to(uint64_t x) {
+				if ((i >= ef->count) || (**this >= x)) return *this;
+				if ((x >> ef->L) > pos - i) return *this = ef->next_geq(x);
+				while ((++(*this)).i < ef->count && (**this < x)) {}
+				return *this;
+			}
+			friend bool operator==(const const_iterator &a, const const_iterator &b) { return a.i == b.i; }
+			friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a.i != b.i; }
+
+		protected:
+			const EliasFano  *ef = nullptr;
+			Size_t			 i = 0;		///< indice de la valeur courante
+			Size_t			 pos = 0;	///< position de son bit à 1 dans highs
+			const_iterator(const EliasFano *ef, Size_t i, Size_t pos) : ef(ef), i(i), pos(pos) {}
+			friend class EliasFano;
+		};
+
+		/// suite vide
+		EliasFano() : EliasFano(static_cast<const uint64_t*>(nullptr), static_cast<const uint64_t*>(nullptr)) {}
+		/// @brief codage des valeurs de [first, last[ (suite croissante au sens large).
+		template <class It> EliasFano(It first, It last) : count(Size_t(std::distance(first, last))), L(0), lows(1), index(highs) {
+			const uint64_t  umax = count ? uint64_t(*std::prev(last)) : 0;
+			// L = plancher(log2(umax/n))
+			if (count && (umax / count > 0)) L = MSB(umax / count) - 1;
+			if (L) lows = varPackedVector(L);
+			lows.reserve(count);
+			const Size_t  nbits = high_size(count, umax >> L);
+			std::vector<Stream::storage_type>  bits(nbits / Stream::storage_unit_size, 0);
+			Size_t  i = 0;
+			uint64_t  previous = 0;
+			for(It it=first;it!=last;++it, ++i) {
+				const uint64_t  v = uint64_t(*it);
+				BITS_ASSERT( (v >= previous) && "EliasFano: suite non croissante");
+				previous = v;
+				if (L) lows.push_back(v & mask<uint64_t>(0, L));
+				const Size_t  p = Size_t(v >> L) + i;
+				bits[p / Stream::storage_unit_size] |= Stream::storage_type(1) << (p % Stream::storage_unit_size);
+			}
+			(void)previous;	// utilisé par BITS_ASSERT seulement
+			set_highs(bits);
+			upper = umax;
+		}
+		explicit EliasFano(const std::vector<uint64_t> &values) : EliasFano(values.begin(), values.end()) {}
+
+		/// l'index pointe sur les mots de highs: il est reconstruit à la copie (le déplacement conserve les mots)
+		EliasFano(const EliasFano &e) : count(e.count), L(e.L), upper(e.upper), lows(e.lows), highs(e.highs), index(highs) {}
+		EliasFano(EliasFano &&) = default;
+		EliasFano& operator=(const EliasFano &e) {
+			if (this != &e) *this = EliasFano(e);
+			return *this;
+		}
+		EliasFano& operator=(EliasFano &&) = default;
+
+		/// nombre de valeurs et nombre de bits de poids faible par valeur
+		inline Size_t size() const { return count; }
+		inline bool empty() const { return count == 0; }
+		inline Size_t low_bits() const { return L; }
+		/// nombre de bits du codage (sans l'index) et place mémoire totale (octets)
+		inline size_t bit_size() const { return size_t(count)*L + highs.get_bit_size(); }
+		inline size_t memory() const { return lows.memory() + highs.get_size()*sizeof(Stream::storage_type) + index.memory(); }
+
+		/// valeur d'indice i (i < size())
+		inline uint64_t access(Size_t i) const {
+			BITS_ASSERT( (i < count) && "EliasFano: indice hors de la suite");
+			return value(i, index.select1(i));
+		}
+		inline uint64_t operator[](Size_t i) const { return access(i); }
+		inline uint64_t front() const { return access(0); }
+		inline uint64_t back() const { return upper; }
+
+		inline const_iterator begin() const { return count ? const_iterator(this, 0, next_one(0)) : end(); }
+		inline const_iterator end() const { return const_iterator(this, count, 0); }
+
+		/// @brief premier élément >= x (end() s'il n'y en a pas).
+		/// @detail select0 donne le début du paquet des valeurs de poids fort x >> L, puis les valeurs
+		/// du paquet sont comparées une à une (une ou deux en moyenne).
+		const_iterator next_geq(uint64_t x) const {
+			if ((count == 0) || (x > upper)) return end();
+			const uint64_t  hx = x >> L;
+			// hx <= back() >> L < nombre de 0 de highs: select0(hx - 1) existe
+			const Size_t  start = hx ? index.select0(Size_t(hx - 1)) + 1 : 0;
+			const_iterator  it(this, Size_t(start - hx), next_one(start));
+			while (*it < x) ++it;
+			return it;
+		}
+
+		/// @brief écriture dans le flux: nombre de valeurs (32 bits), L (7 bits), taille de highs (32 bits),
+		/// puis les bits de poids faible (comme des Block<L>) et les mots de highs.
+		friend Stream& operator<<(Stream &stream, const EliasFano &e) {
+			stream.write_bits(e.count, 32);
+			stream.write_bits(e.L, 7);
+			stream.write_bits(e.highs.get_bit_size(), 32);
+			if (e.L) stream << e.lows;
+			for(Size_t k=0;k<e.highs.get_size();++k) stream.write_bits(e.highs.get_data()[k], Stream::storage_unit_size);
+			return stream;
+		}
+		/// @brief relecture à partir du curseur de lecture du flux (qui avance).
+		/// @detail retourne faux (et laisse la suite inchangée) si les données sont incohérentes ou incomplètes.
+		bool read(Stream &stream) {
+			const auto  remaining = [&stream]() { return uint64_t(stream.get_bit_size() - stream.getReadPosition().LastBit()); };
+			if (remaining() < 71) return false;
+			EliasFano  r;
+			r.count = stream.get_bits(32);
+			r.L = stream.get_bits(7);
+			const Size_t  nbits = stream.get_bits(32);
+			if ((r.L > 63) || (nbits % 64) || (nbits < uint64_t(r.count) + 1) || (remaining() < uint64_t(r.count)*r.L + nbits)) return false;
+			if (r.L) {
+				r.lows = varPackedVector(r.L);
+				r.lows.read(stream, r.count);
+			}
+			std::vector<Stream::storage_type>  bits(nbits / Stream::storage_unit_size);
+			for(auto &w : bits) w = stream.get_bits(Stream::storage_unit_size);
+			r.set_highs(bits);
+			if (r.index.ones() != r.count) return false;
+			r.upper = r.count ? r.access(r.count - 1) : 0;
+			*this = std::move(r);
+			return true;
+		}
+
+	protected:
+		Size_t			count;		///< nombre de valeurs
+		Size_t			L;			///< nombre de bits de poids faible
+		uint64_t		upper = 0;	///< dernière valeur (0 pour une suite vide)
+		varPackedVector	lows;		///< bits de poids faible (vide si L = 0)
+		Stream			highs;		///< bits de poids fort en unaire
+		RankSelect		index;		///< index sur highs
+
+		/// taille de highs: un 1 par valeur, un 0 par paquet de poids fort, arrondi à 64 bits
+		static inline Size_t high_size(Size_t n, uint64_t hmax) {
+			const uint64_t  nbits = uint64_t(n) + hmax + 1;
+			BITS_ASSERT( (nbits < (uint64_t(1) << 32) - 64) && "EliasFano: suite trop longue");
+			return Size_t((nbits + 63) / 64 * 64);
+		}
+		/// remplace highs par les mots bits et reconstruit l'index
+		void set_highs(const std::vector<Stream::storage_type> &bits) {
+			const Size_t  nbits = Size_t(bits.size()) * Stream::storage_unit_size;
+			Stream  s(nbits + 1);
+			for(auto w : bits) s.write_bits(w, Stream::storage_unit_size);
+			highs = std::move(s);
+			index = RankSelect(highs);
+		}
+		/// position du premier 1 de highs à partir de p (il doit en exister un)
+		inline Size_t next_one(Size_t p) const {
+			const Stream::storage_type  *w = highs.get_data();
+			Size_t  k = p / 64;
+			uint64_t  v = (uint64_t(w[2*k]) | (uint64_t(w[2*k + 1]) << 32)) & (~uint64_t(0) << (p % 64));
+			while (!v) { ++k; v = uint64_t(w[2*k]) | (uint64_t(w[2*k + 1]) << 32); }
+			return k*64 + TrailingZeros(v);
+		}
+		/// valeur d'indice i dont le bit de poids fort est à la position pos de highs
+		inline uint64_t value(Size_t i, Size_t pos) const {
+			const uint64_t  high = uint64_t(pos - i) << L;
+			return L ? high | lows.get(i) : high;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,173 @@
+/// library: bitstream / BitFile.h (écriture et lecture de fichiers en parallèle du codage)
+/// + Bits::FileWriter : le codeur écrit dans stream(); dès que chunk octets sont prêts, ils sont
+///   écrits dans le fichier par un thread pendant que le codeur remplit le second tampon.
+/// + Bits::FileReader : le paquet suivant du fichier est lu par un thread pendant que le décodeur
+///   travaille sur le paquet courant.
+/// + le fichier contient les octets du flux (ceux de get_buffer()), sans entête: le format est celui
+///   d'un flux écrit d'un bloc par ofstream::write(get_buffer(), get_byte_size()).
+/// + la durée totale tend vers max(codage, entrées/sorties) au lieu de leur somme.
+
+#ifndef _BITFILE
+#define _BITFILE
+#include <cstdint>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include "BitBase.h"
+#include "BitStream.h"
+
+namespace Bits {
+	/// class Bits::FileWriter
+	/// Usage: écrire dans stream(), appeler commit() régulièrement (par exemple après chaque
+	/// enregistrement), puis close(). commit() confie au thread d'écriture les mots complets du flux
+	/// dès qu'ils dépassent chunk octets; les bits du dernier mot partiel restent dans stream().
+	/// stream() ne doit pas être relu (seul son curseur d'écriture a un sens).
+	class FileWriter {
+	public:
+		/// @param chunk taille des paquets écrits (octets, arrondie à un multiple de 4)
+		explicit FileWriter(const std::string &path, Size_t chunk = 1u << 20) :
+			file(path, std::ios::out | std::ios::binary),
+			chunk(std::max(Size_t(4), chunk & ~Size_t(3))),
+			active(8*(this->chunk + 256)), spare(8*(this->chunk + 256)),
+			ok(bool(file)) {}
+		~FileWriter() { close(); }
+
+		/// faux si le fichier n'a pas pu être ouvert ou si une écriture a échoué (attend l'écriture en cours)
+		inline bool valid() {
+			wait();
+			return ok;
+		}
+		/// flux à remplir
+		inline Stream& stream() { return active; }
+		/// nombre total de bits écrits (fichier et stream())
+		inline uint64_t bit_size() const { return shipped + active.get_bit_size(); }
+
+		/// @brief envoie les mots complets de stream() au thread d'écriture s'ils dépassent chunk octets
+		inline void commit() {
+			if (active.get_byte_size() >= chunk) ship();
+		}
+		/// @brief écrit la fin du flux (dernier octet complété par des 0) et ferme le fichier.
+		/// Retourne faux si une écriture a échoué.
+		bool close() {
+			if (!file.is_open()) return ok;
+			ship();
+			wait();
+			if (ok && active.get_byte_size()) ok = bool(file.write(active.get_buffer(), std::streamsize(active.get_byte_size())));
+			shipped += active.get_bit_size();
+			active.reset();
+			file.close();
+			return ok;
+		}
+
+	protected:
+		std::ofstream	file;
+		Size_t			chunk;
+		Stream			active;			///< tampon rempli par le codeur
+		Stream			spare;			///< tampon en cours d'écriture par worker
+		std::thread		worker;
+		bool			ok;				///< modifié par worker: lu seulement après wait()
+		uint64_t		shipped = 0;	///< bits confiés à worker
+
+		inline void wait() {
+			if (worker.joinable()) worker.join();
+		}
+		/// échange des tampons: les mots complets partent dans spare, le mot partiel reste dans active
+		void ship() {
+			const Size_t  bits = active.get_bit_size(), full = bits - bits % Stream::storage_unit_size;
+			if (full == 0) return;
+			wait();
+			std::swap(active, spare);
+			active.reset();
+			if (bits > full) active.write_bits(spare.read_bits(full, bits - full), bits - full);
+			shipped += full;
+			if (!ok) return;
+			worker = std::thread([this, full] {
+				if (!file.write(spare.get_buffer(), std::streamsize(full / 8))) ok = false;
+			});
+		}
+	};
+
+	/// class Bits::FileReader
+	/// Usage: avant chaque lecture d'au plus n bits dans stream(), appeler ensure(n), qui ajoute
+	/// au flux le paquet suivant du fichier (déjà lu par le thread) si moins de n bits restent à lire.
+	/// Les bits déjà lus sont alors abandonnés: positions et seek ne sont valables qu'entre deux ensure().
+	class FileReader {
+	public:
+		static constexpr uint64_t All = ~uint64_t(0);
+
+		/// @param nbits nombre de bits du flux enregistré (par défaut: tout le fichier)
+		/// @param chunk taille des paquets lus (octets, arrondie à un multiple de 4)
+		explicit FileReader(const std::string &path, uint64_t nbits = All, Size_t chunk = 1u << 20) :
+			file(path, std::ios::in | std::ios::binary),
+			chunk(std::max(Size_t(4), chunk & ~Size_t(3))),
+			active(8*(this->chunk + 256)), spare(8*(this->chunk + 256)), next(8*(this->chunk + 256)),
+			remaining(nbits), ok(bool(file)) {
+			if (ok) prefetch();
+		}
+		~FileReader() { wait(); }
+
+		/// faux si le fichier n'a pas pu être ouvert, si une lecture a échoué, ou s'il contient moins de
+		/// nbits bits (attend la lecture en cours)
+		inline bool valid() {
+			wait();
+			return ok;
+		}
+		/// flux à lire
+		inline Stream& stream() { return active; }
+		/// nombre de bits restant à lire dans stream()
+		inline Size_t available() const { return active.get_bit_size() - active.getReadPosition().LastBit(); }
+		/// @brief garantit que n bits au moins sont lisibles dans stream(). Retourne faux si le fichier
+		/// se termine avant (les derniers bits restent lisibles).
+		inline bool ensure(Size_t n) { return (available() >= n) || refill(n); }
+
+	protected:
+		std::ifstream	file;
+		Size_t			chunk;
+		Stream			active;		///< tampon lu par le décodeur
+		Stream			spare;		///< tampon de recomposition (fin de active + next)
+		Stream			next;		///< paquet en cours de lecture par worker
+		std::thread		worker;
+		uint64_t		remaining;	///< bits du fichier pas encore confiés à worker
+		bool			ok;			///< modifié par worker: lu seulement après wait()
+
+		inline void wait() {
+			if (worker.joinable()) worker.join();
+		}
+		/// lecture du paquet suivant dans next par worker
+		void prefetch() {
+			next.reset();
+			if (remaining == 0) return;
+			const Size_t  bytes = (remaining == All) ? chunk : Size_t(std::min(uint64_t(chunk), (remaining + 7) / 8));
+			worker = std::thread([this, bytes] {
+				file.read(next.get_buffer(), std::streamsize(bytes));
+				const Size_t	got = Size_t(file.gcount());
+				const uint64_t  bits = std::min(uint64_t(8) * got, remaining);
+				if (bits) next.write_seek(Size_t(bits));
+				if (got < bytes) {
+					if (remaining != All) ok = false;
+					remaining = 0;
+				} else if (remaining != All) remaining -= bits;
+			});
+		}
+		/// fin de active (à partir du mot contenant le curseur de lecture) suivie de next
+		bool refill(Size_t n) {
+			while (available() < n) {
+				wait();
+				if (next.get_bit_size() == 0) return false;
+				const Size_t  read = active.getReadPosition().LastBit(),
+							  from = read - read % Stream::storage_unit_size;
+				spare.reset();
+				spare.copy_bits(active, from, active.get_bit_size() - from);
+				spare.append(next);
+				spare.seek(read - from);
+				std::swap(active, spare);
+				prefetch();
+			}
+			return true;
+		}
+	};
+}
+
+#endif
@@ -6,37 +6,66 @@
 /// + Bits::varBlock : Block avec un nombre de bits valides variable
 /// + ajout d'une fonction Binary pour visualiser les données en binaires dans un flux.
 /// + ajout de tests unitaires pour validation
+/// 1.2-1 : conversion exacte depuis l'exposant/la mantisse IEEE-754, get() sans boucle,
+///         variante Bits::Float128 (stockage sur 128 bits)
 
 #ifndef _BITFLOAT
 #define _BITFLOAT
 #include <cstdint>
 #include <iostream>
+#include <cmath>
+#include <cstring>
 #include "BitBase.h"
 
 namespace Bits {
-	class Float {
+	/// class Bits::BasicFloat
+	/// binaire fractionnaire (nombre de [0,1[) stocké dans les bits d'un entier non signé:
+	/// le MSB du stockage est le bit de poids 2^-1.
+	/// Bits::Float stocke 64 bits, Bits::Float128 (si le compilateur a un entier 128 bits) 128 bits.
+	template <typename StorageType> class BasicFloat {
 	private:
-		using storage_t = uint64_t;			///< type sous-jacent de stockage
-		static const int MaxBits = 64;		///< nombre de bit du type sous-jacent
-		static const storage_t Mask = 1ULL << (MaxBits - 1); ///< masque pour extraction du MSB
+		using storage_t = StorageType;		///< type sous-jacent de stockage
+		static const int MaxBits = 8*int(sizeof(storage_t));	///< nombre de bit du type sous-jacent
+		/// masque pour extraction du MSB
+		static storage_t Mask() { return storage_t(1) << (MaxBits - 1); }
+		/// nombre de bits à 0 après le dernier bit à 1 (x != 0)
+		static int trailing_zeros(storage_t x) {
+			int  n = 0;
+			for(;!(x & storage_t(0xFFFFFFFFu));x >>= 32) n += 32;
+#if defined(__GNUC__) || defined(__clang__)
+			return n + __builtin_ctz(uint32_t(x));
+#else
+			for(;!(x & 1u);x >>= 1) ++n;
+			return n;
+#endif
+		}
 		storage_t		storage;			///< stokage du flottant en binaire fractionnaire
 		uint32_t		valid;				///< nombre de bits valides dans le flottant
 	public:
 		/// constructeur à partir d'un double: remplit le Bits:Float à partir d'un double
-		/// logiquement, le nombre de bits valide à la fin de ce constructeur est 53
-		Float(double v) : storage(0), valid(0) {
-			assert((v >= 0.0) && (v < 1.0));
-			while (v != 0.0) {
-				storage <<= 1;
-				v *= 2.0;
-				if (v >= 1.0) {
-					v -= 1.0;
-					storage |= 1;
-				}
-				++valid;
-				if (valid == MaxBits) break;
+		/// logiquement, le nombre de bits valide à la fin de ce constructeur est 53 au plus pour un
+		/// double normalisé (valid = position du dernier bit à 1), ou MaxBits si des bits sont perdus.
+		/// La conversion se fait directement depuis la mantisse et l'exposant du double.
+		BasicFloat(double v) : storage(0), valid(0) {
+			BITS_ASSERT((v >= 0.0) && (v < 1.0));
+			uint64_t  ieee;
+			memcpy(&ieee, &v, sizeof(ieee));
+			int		  exponent = int((ieee >> 52) & 0x7FF);
+			uint64_t  mantissa = ieee & ((uint64_t(1) << 52) - 1);
+			if (exponent) mantissa |= uint64_t(1) << 52;	// bit implicite des nombres normalisés
+			else exponent = 1;								// dénormalisés
+			if (mantissa == 0) return;
+			// v = mantissa * 2^(exponent-1075): le bit de poids 2^-MaxBits est à la position shift
+			int   shift = exponent - 1075 + MaxBits;
+			bool  lost = false;
+			if (shift >= 0) storage = storage_t(mantissa) << shift;
+			else if (shift > -64) {
+				storage = storage_t(mantissa >> -shift);
+				lost = (mantissa & ((uint64_t(1) << -shift) - 1)) != 0;
 			}
-			storage <<= MaxBits - valid;
+			else lost = true;
+			// comme le développement bit à bit: arrêt sur le dernier bit à 1, ou après MaxBits bits
+			valid = uint32_t(lost ? MaxBits : MaxBits - trailing_zeros(storage));
 		}
 
 		/// retourne le nombre de bits valide dans le mot
@@ -45,7 +74,7 @@ namespace Bits {
 		uint32_t getValidBits() const { return valid;  }
 
 		/// constructeur par défaut: construit un flottant binaire fractionnaire égal à 0
-		Float() : storage(0), valid(0) {}
+		BasicFloat() : storage(0), valid(0) {}
 
 		/// shift le nombre binaire à gauche de nshift bit = fait perdre les nshift MSB.
 		/// dans l'algorithme, associé au décalage de la position de départ.
@@ -58,52 +87,49 @@ namespace Bits {
 		/// ajoute un bit en dernière position du binaire fractionnaire.
 		/// augmente le nombre de bits valide de 1.
 		bool push(Bit v) {
-			assert((v == 0) || (v == 1));
-			if (valid == MaxBits) return false;
+			BITS_ASSERT((v == 0) || (v == 1));
+			if (valid == uint32_t(MaxBits)) return false;
 			++valid;
-			storage |= static_cast<storage_t>(v) << (MaxBits - valid);
+			storage |= static_cast<storage_t>(v) << (MaxBits - int(valid));
 			return true;
 		}
 
 		/// retourne le double associé au binaire fractionnaire complet
+		/// (exact tant que les bits à 1 tiennent sur 53 bits, arrondi au plus proche sinon)
 		double get() const {
-			double    pow2 = 0.5, r=0.0;
-			storage_t  v = storage;
-			while (v != 0) {
-				if (v & Mask) r += pow2;
-				v <<= 1;
-				pow2 /= 2.0;
-			}
-			return r;
+			return std::ldexp(double(storage), -MaxBits);
 		}
 
 		/// retourne le double associé au binaire fractionnaire allant des bits first é first+nb-1
 		/// bit de poids le plus fort = 1
 		double get(int first, int nb) const {
-			double    pow2 = 0.5, r = 0.0;
+			if (nb <= 0) return 0.0;
 			storage_t  v = storage << (first-1);
-			for (int i = 0; i < nb; i++) {
-				if (v & Mask) r += pow2;
-				v <<= 1;
-				pow2 /= 2.0;
-			}
-			return r;
+			if (nb >= MaxBits) return std::ldexp(double(v), -MaxBits);
+			return std::ldexp(double(v >> (MaxBits - nb)), -nb);
 		}
 
 		/// surcharge d'un Bits::Float dans le flux de sortie
 		/// l'affiche sous forme binaire précédé d'un point
 		/// le nombre de bits affichs correspond au nombre de bits valides
-		friend std::ostream& operator<<(std::ostream& os, const Float &f) {
+		friend std::ostream& operator<<(std::ostream& os, const BasicFloat &f) {
 			storage_t   v = f.storage;
 			os << '.';
 			for (uint32_t i = 0; i < f.valid; i++) {
-				os << (v & f.Mask ? 1 : 0);
+				os << (v & Mask() ? 1 : 0);
 				v <<= 1;
 			}
 			return os;
 		}
 
 	};
+
+	/// binaire fractionnaire sur 64 bits
+	using Float = BasicFloat<uint64_t>;
+#ifdef __SIZEOF_INT128__
+	/// binaire fractionnaire sur 128 bits (intervalles plus longs)
+	using Float128 = BasicFloat<unsigned __int128>;
+#endif
 }
 
 #endif
@@ -0,0 +1,211 @@
+/// library: bitstream / BitOps.h (opérations logiques entre flux)
+/// + and, or, xor, andnot entre deux flux (ou un flux et une vue sur des mots), sur les bits écrits,
+///   avec résultat dans un nouveau flux (&, |, ^, andnot) ou dans le premier flux (&=, |=, ^=,
+///   andnot_assign).
+/// + popcount d'un flux et popcount du résultat d'une opération sans le construire.
+/// + calcul par mots: AVX2 (256 bits) si le processeur le permet, boucle sur 64 bits sinon.
+/// Les opérandes de longueurs différentes sont complétés par des 0; le résultat a la longueur du
+/// plus long. Les bits du dernier mot situés après la fin des données ne sont jamais lus.
+
+#ifndef _BITOPS
+#define _BITOPS
+#include <cstdint>
+#include <cstring>
+#include "BitBase.h"
+#include "BitStream.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BITS_OPS_AVX2
+#endif
+
+namespace Bits {
+	/// @brief vue en lecture seule sur nbits bits rangés dans des mots comme dans un Bits::Stream.
+	struct View {
+		using storage_type = Stream::storage_type;
+		enum : Size_t { unit = Stream::storage_unit_size };
+		const storage_type	*words;
+		Size_t				nbits;
+		View(const storage_type *words, Size_t nbits) : words(words), nbits(nbits) {}
+		/// vue sur les données écrites d'un flux
+		View(const Stream &s) : words(s.get_data()), nbits(s.get_bit_size()) {}
+		/// nombre de mots complets et nombre total de mots
+		inline Size_t full_words() const { return nbits / unit; }
+		inline Size_t nwords() const { return (nbits + unit - 1) / unit; }
+		/// mot i, les bits au-delà de nbits (et les mots au-delà des données) valant 0
+		inline storage_type word(Size_t i) const {
+			if (i < full_words()) return words[i];
+			if (i >= nwords()) return 0;
+			return storage_type(words[i] & mask<storage_type>(0, nbits % unit));
+		}
+	};
+
+	/// opérations logiques: calcul sur 64 bits et sur 256 bits
+	namespace Op {
+		struct And {
+			static inline uint64_t apply(uint64_t a, uint64_t b) { return a & b; }
+#ifdef BITS_OPS_AVX2
+			__attribute__((target("avx2"))) static inline __m256i apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+		};
+		struct Or {
+			static inline uint64_t apply(uint64_t a, uint64_t b) { return a | b; }
+#ifdef BITS_OPS_AVX2
+			__attribute__((target("avx2"))) static inline __m256i apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+		};
+		struct Xor {
+			static inline uint64_t apply(uint64_t a, uint64_t b) { return a ^ b; }
+#ifdef BITS_OPS_AVX2
+			__attribute__((target("avx2"))) static inline __m256i apply(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+#endif
+		};
+		/// a and not b
+		struct AndNot {
+			static inline uint64_t apply(uint64_t a, uint64_t b) { return a & ~b; }
+#ifdef BITS_OPS_AVX2
+			__attribute__((target("avx2"))) static inline __m256i apply(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#endif
+		};
+		/// opérande seul (pour popcount d'un flux)
+		struct First {
+			static inline uint64_t apply(uint64_t a, uint64_t) { return a; }
+#ifdef BITS_OPS_AVX2
+			__attribute__((target("avx2"))) static inline __m256i apply(__m256i a, __m256i) { return a; }
+#endif
+		};
+	}
+
+	/// noyaux de calcul sur n mots complets
+	namespace OpsImpl {
+		using storage_type = Stream::storage_type;
+
+		template <class O> void apply_scalar(storage_type *dst, const storage_type *a, const storage_type *b, Size_t n) {
+			Size_t  i = 0;
+			for(;i + 2 <= n;i += 2) {
+				uint64_t  x, y;
+				memcpy(&x, a + i, 8);
+				memcpy(&y, b + i, 8);
+				x = O::apply(x, y);
+				memcpy(dst + i, &x, 8);
+			}
+			for(;i < n;++i) dst[i] = storage_type(O::apply(a[i], b[i]));
+		}
+		template <class O> uint64_t count_scalar(const storage_type *a, const storage_type *b, Size_t n) {
+			uint64_t  c = 0;
+			Size_t	  i = 0;
+			for(;i + 2 <= n;i += 2) {
+				uint64_t  x, y;
+				memcpy(&x, a + i, 8);
+				memcpy(&y, b + i, 8);
+				c += PopCount(O::apply(x, y));
+			}
+			for(;i < n;++i) c += PopCount(O::apply(a[i], b[i]) & 0xFFFFFFFFu);
+			return c;
+		}
+#ifdef BITS_OPS_AVX2
+		template <class O> __attribute__((target("avx2")))
+		void apply_avx2(storage_type *dst, const storage_type *a, const storage_type *b, Size_t n) {
+			Size_t  i = 0;
+			for(;i + 8 <= n;i += 8) {
+				__m256i  x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+				__m256i  y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), O::apply(x, y));
+			}
+			apply_scalar<O>(dst + i, a + i, b + i, n - i);
+		}
+		/// popcount par table des quartets (vpshufb) et sommes par octets (vpsadbw)
+		template <class O> __attribute__((target("avx2")))
+		uint64_t count_avx2(const storage_type *a, const storage_type *b, Size_t n) {
+			const __m256i  table = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+			const __m256i  low = _mm256_set1_epi8(0x0F);
+			__m256i  total = _mm256_setzero_si256();
+			Size_t	 i = 0;
+			while (i + 8 <= n) {
+				// au plus 31 itérations avant de vider les compteurs 8 bits (31*8 < 256)
+				__m256i  acc = _mm256_setzero_si256();
+				for(int k=0;(k < 31) && (i + 8 <= n);++k, i += 8) {
+					__m256i  x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+					__m256i  y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+					__m256i  v = O::apply(x, y);
+					__m256i  lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+					__m256i  hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+					acc = _mm256_add_epi8(acc, _mm256_add_epi8(lo, hi));
+				}
+				total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, _mm256_setzero_si256()));
+			}
+			uint64_t  lanes[4];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), total);
+			return lanes[0] + lanes[1] + lanes[2] + lanes[3] + count_scalar<O>(a + i, b + i, n - i);
+		}
+		inline bool has_avx2() {
+			static const bool  avx2 = __builtin_cpu_supports("avx2");
+			return avx2;
+		}
+#endif
+		/// choix du calcul AVX2 ou scalaire
+		template <class O> void apply(storage_type *dst, const storage_type *a, const storage_type *b, Size_t n) {
+#ifdef BITS_OPS_AVX2
+			if (has_avx2()) { apply_avx2<O>(dst, a, b, n); return; }
+#endif
+			apply_scalar<O>(dst, a, b, n);
+		}
+		template <class O> uint64_t count(const storage_type *a, const storage_type *b, Size_t n) {
+#ifdef BITS_OPS_AVX2
+			if (has_avx2()) return count_avx2<O>(a, b, n);
+#endif
+			return count_scalar<O>(a, b, n);
+		}
+
+		/// dst[0..nwords(max)[ = a op b: mots complets communs par le noyau, le reste mot par mot
+		template <class O> void combine(storage_type *dst, const View &a, const View &b) {
+			const Size_t  common = std::min(a.full_words(), b.full_words());
+			const Size_t  n = std::max(a.nwords(), b.nwords());
+			apply<O>(dst, a.words, b.words, common);
+			for(Size_t i=common;i<n;++i) dst[i] = storage_type(O::apply(a.word(i), b.word(i)));
+		}
+	}
+
+	/// @brief popcount de a op b, sans construire le résultat (ex: popcount<Op::And>(a, b)).
+	template <class O> uint64_t popcount(const View &a, const View &b) {
+		const Size_t  common = std::min(a.full_words(), b.full_words());
+		const Size_t  n = std::max(a.nwords(), b.nwords());
+		uint64_t  c = OpsImpl::count<O>(a.words, b.words, common);
+		for(Size_t i=common;i<n;++i) c += PopCount(O::apply(a.word(i), b.word(i)) & 0xFFFFFFFFu);
+		return c;
+	}
+	/// @brief nombre de bits à 1 dans les données de a.
+	inline uint64_t popcount(const View &a) { return popcount<Op::First>(a, a); }
+
+	/// @brief résultat de a op b dans un nouveau flux, de la longueur du plus long des opérandes.
+	template <class O> Stream combine(const View &a, const View &b) {
+		const Size_t  nbits = std::max(a.nbits, b.nbits);
+		Stream  r(nbits + 1);
+		OpsImpl::combine<O>(r.get_data(), a, b);
+		r.write_seek(nbits);
+		return r;
+	}
+	/// @brief a = a op b. a est prolongé par des 0 si b est plus long.
+	template <class O> Stream& combine_assign(Stream &a, const View &b) {
+		// b peut lire les données partagées de a: elles restent allouées jusqu'à la fin du calcul,
+		// même si own() (ou l'agrandissement de a) en donne une copie propre à a
+		const Stream::Frozen  previous = a.is_shared() ? a.freeze() : Stream::Frozen();
+		while (a.get_bit_size() < b.nbits)
+			a.write_bits(0, std::min(Size_t(Stream::storage_unit_size), b.nbits - a.get_bit_size()));
+		a.own();
+		OpsImpl::combine<O>(a.get_data(), View(a), b);
+		return a;
+	}
+
+	inline Stream operator&(const View &a, const View &b) { return combine<Op::And>(a, b); }
+	inline Stream operator|(const View &a, const View &b) { return combine<Op::Or>(a, b); }
+	inline Stream operator^(const View &a, const View &b) { return combine<Op::Xor>(a, b); }
+	/// a and not b
+	inline Stream andnot(const View &a, const View &b) { return combine<Op::AndNot>(a, b); }
+	inline Stream& operator&=(Stream &a, const View &b) { return combine_assign<Op::And>(a, b); }
+	inline Stream& operator|=(Stream &a, const View &b) { return combine_assign<Op::Or>(a, b); }
+	inline Stream& operator^=(Stream &a, const View &b) { return combine_assign<Op::Xor>(a, b); }
+	inline Stream& andnot_assign(Stream &a, const View &b) { return combine_assign<Op::AndNot>(a, b); }
+}
+
+#endif
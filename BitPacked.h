@@ -0,0 +1,250 @@
+/// library: bitstream / BitPacked.h (tableaux de valeurs compactées)
+/// + Bits::PackedVector<NBITS> : tableau de valeurs de NBITS bits (1 à 64) stockées consécutivement,
+///   sans bit perdu (un std::vector<Bits::Block<5>> utilise 8 bits par valeur).
+/// + Bits::varPackedVector : même chose avec un nombre de bits fixé à l'exécution.
+/// + accès get(i)/set(i) en O(1), operator[], itérateurs, push_back, resize.
+/// + les bits sont rangés comme dans un Bits::Stream où chaque valeur aurait été écrite par
+///   stream << Block<NBITS>(v) (MSB en premier): l'écriture dans un flux et la construction à partir
+///   d'un flux se font par mots entiers, sans recompacter les valeurs.
+
+#ifndef _BITPACKED
+#define _BITPACKED
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <iterator>
+#include "BitBase.h"
+#include "BitBlock.h"
+#include "BitStream.h"
+
+namespace Bits {
+	/// largeur fixée à la compilation
+	template <int NBITS> struct FixedWidth {
+		static_assert((NBITS >= 1) && (NBITS <= 64), "PackedVector: 1 à 64 bits par valeur");
+		using value_type = typename Block<NBITS>::Type;
+		static constexpr Size_t width() { return Size_t(NBITS); }
+	};
+	/// largeur fixée à l'exécution
+	struct VarWidth {
+		using value_type = uint64_t;
+		Size_t	nbits = 64;
+		VarWidth() = default;
+		explicit VarWidth(Size_t nbits) : nbits(nbits) {
+			BITS_ASSERT( (nbits >= 1) && (nbits <= 64) && "varPackedVector: 1 à 64 bits par valeur");
+		}
+		inline Size_t width() const { return nbits; }
+	};
+
+	/// class Bits::BasicPackedVector
+	/// Les mots de stockage sont ceux d'un Bits::Stream (bit 0 du mot 0 = premier bit). Deux mots nuls
+	/// sont toujours présents après les données, ce qui permet de lire ou d'écrire une valeur de 64 bits
+	/// à n'importe quelle position par trois mots au plus, sans test de fin de tableau.
+	template <class Width> class BasicPackedVector : protected Width {
+	public:
+		using storage_type = Stream::storage_type;
+		using value_type = typename Width::value_type;
+		using size_type = size_t;
+		enum : Size_t { unit = Stream::storage_unit_size, Padding = 2 };
+
+		/// référence sur un élément (cf std::vector<bool>)
+		class Reference {
+		public:
+			inline operator value_type() const { return v->get(i); }
+			inline Reference& operator=(value_type x) { v->set(i, x); return *this; }
+			inline Reference& operator=(const Reference &r) { v->set(i, value_type(r)); return *this; }
+			/// échange des valeurs (utilisé par les algorithmes de la STL, ex: std::sort)
+			friend inline void swap(Reference a, Reference b) {
+				value_type  t = a;
+				a = value_type(b);
+				b = t;
+			}
+		protected:
+			BasicPackedVector	*v;
+			size_t				i;
+			Reference(BasicPackedVector *v, size_t i) : v(v), i(i) {}
+			friend class BasicPackedVector;
+		};
+
+		/// itérateur à accès direct (Ref = value_type pour l'itérateur constant)
+		template <class Vec, class Ref> class Iterator {
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = typename BasicPackedVector::value_type;
+			using difference_type = std::ptrdiff_t;
+			using reference = Ref;
+			using pointer = void;
+			Iterator() : v(nullptr), i(0) {}
+			Iterator(Vec *v, size_t i) : v(v), i(i) {}
+			/// conversion itérateur -> itérateur constant
+			template <class V2, class R2> Iterator(const Iterator<V2,R2> &it) : v(it.v), i(it.i) {}
+			inline Ref operator*() const { return (*v)[i]; }
+			inline Ref operator[](difference_type d) const { return (*v)[size_t(difference_type(i) + d)]; }
+			inline Iterator& operator++() { ++i; return *this; }
+			inline Iterator& operator--() { --i; return *this; }
+			inline Iterator operator++(int) { Iterator  t(*this); ++i; return t; }
+			inline Iterator operator--(int) { Iterator  t(*this); --i; return t; }
+			inline Iterator& operator+=(difference_type d) { i = size_t(difference_type(i) + d); return *this; }
+			inline Iterator& operator-=(difference_type d) { i = size_t(difference_type(i) - d); return *this; }
+			inline Iterator operator+(difference_type d) const { Iterator  t(*this); return t += d; }
+			inline Iterator operator-(difference_type d) const { Iterator  t(*this); return t -= d; }
+			friend inline Iterator operator+(difference_type d, const Iterator &it) { return it + d; }
+			inline difference_type operator-(const Iterator &it) const { return difference_type(i) - difference_type(it.i); }
+			inline bool operator==(const Iterator &it) const { return i == it.i; }
+			inline bool operator!=(const Iterator &it) const { return i != it.i; }
+			inline bool operator<(const Iterator &it) const { return i < it.i; }
+			inline bool operator>(const Iterator &it) const { return i > it.i; }
+			inline bool operator<=(const Iterator &it) const { return i <= it.i; }
+			inline bool operator>=(const Iterator &it) const { return i >= it.i; }
+		protected:
+			Vec		*v;
+			size_t	i;
+			template <class V2, class R2> friend class Iterator;
+		};
+		using iterator = Iterator<BasicPackedVector, Reference>;
+		using const_iterator = Iterator<const BasicPackedVector, value_type>;
+
+		explicit BasicPackedVector(const Width &w = Width()) : Width(w), count(0), words(Padding, 0) {}
+		/// n valeurs égales à x
+		BasicPackedVector(size_t n, value_type x, const Width &w = Width()) : BasicPackedVector(w) { resize(n, x); }
+
+		/// @brief construction à partir des n valeurs écrites dans stream à partir du bit from.
+		/// @detail copie des mots du flux (memcpy si from est aligné sur un mot). Les valeurs absentes
+		/// du flux valent 0.
+		BasicPackedVector(const Stream &stream, size_t n, Size_t from = 0, const Width &w = Width()) : BasicPackedVector(w) {
+			resize(n);
+			const size_t  nbits = std::min(size_t(stream.get_bit_size() - std::min(from, stream.get_bit_size())), n*width());
+			const size_t  full = nbits / unit;
+			if (from % unit == 0) memcpy(words.data(), stream.get_data() + from / unit, full*sizeof(storage_type));
+			else for(size_t k=0;k<full;++k) words[k] = stream.read_bits(Size_t(from + k*unit), unit);
+			if (nbits % unit) words[full] = stream.read_bits(Size_t(from + full*unit), Size_t(nbits % unit));
+		}
+
+		/// nombre de bits par valeur
+		inline Size_t width() const { return Width::width(); }
+		/// nombre de valeurs
+		inline size_t size() const { return count; }
+		inline bool empty() const { return count == 0; }
+		/// nombre de valeurs que le tableau peut contenir sans réallocation
+		inline size_t capacity() const { return ((words.capacity() - Padding) * unit) / width(); }
+		/// place mémoire occupée par les mots de stockage (octets)
+		inline size_t memory() const { return words.capacity() * sizeof(storage_type); }
+		/// nombre de bits occupés par les valeurs
+		inline size_t bit_size() const { return count * width(); }
+		/// mots de stockage (bit_size() bits utiles)
+		inline const storage_type *data() const { return words.data(); }
+
+		/// valeur d'indice i
+		inline value_type get(size_t i) const {
+			BITS_ASSERT( (i < count) && "PackedVector: indice hors du tableau");
+			return value_type(Reverse<uint64_t>(load(i*width(), width()), width()));
+		}
+		/// fixe la valeur d'indice i (les bits au-delà de width() sont perdus)
+		inline void set(size_t i, value_type x) {
+			BITS_ASSERT( (i < count) && "PackedVector: indice hors du tableau");
+			store(i*width(), width(), Reverse<uint64_t>(uint64_t(x), width()));
+		}
+		inline value_type operator[](size_t i) const { return get(i); }
+		inline Reference operator[](size_t i) { return Reference(this, i); }
+		inline value_type front() const { return get(0); }
+		inline value_type back() const { return get(count - 1); }
+
+		inline iterator begin() { return iterator(this, 0); }
+		inline iterator end() { return iterator(this, count); }
+		inline const_iterator begin() const { return const_iterator(this, 0); }
+		inline const_iterator end() const { return const_iterator(this, count); }
+		inline const_iterator cbegin() const { return begin(); }
+		inline const_iterator cend() const { return end(); }
+
+		/// réserve la place pour n valeurs
+		inline void reserve(size_t n) { words.reserve(nwords(n) + Padding); }
+		/// change le nombre de valeurs; les nouvelles valeurs valent x
+		void resize(size_t n, value_type x = 0) {
+			size_t  old = count;
+			if (n < count) {	// remise à 0 des bits libérés (les mots de garde doivent rester nuls)
+				if ((n * width()) % unit) words[nwords(n) - 1] &= mask<storage_type>(0, Size_t((n * width()) % unit));
+				words.resize(nwords(n) + Padding);
+				std::fill(words.begin() + long(nwords(n)), words.end(), storage_type(0));
+			}
+			else words.resize(nwords(n) + Padding, 0);
+			count = n;
+			if (x) for(size_t i=old;i<n;++i) set(i, x);
+		}
+		inline void clear() { resize(0); }
+		/// ajoute une valeur à la fin
+		inline void push_back(value_type x) {
+			if (words.size() < nwords(count + 1) + Padding) words.resize(nwords(count + 1) + Padding, 0);
+			++count;
+			set(count - 1, x);
+		}
+		inline void pop_back() { resize(count - 1); }
+
+		/// écriture des valeurs dans le flux, comme stream << Block<width()>(v) pour chaque valeur
+		friend Stream& operator<<(Stream &stream, const BasicPackedVector &v) {
+			const size_t  nbits = v.bit_size(), full = nbits / unit;
+			for(size_t k=0;k<full;++k) stream.write_bits(v.words[k], unit);
+			if (nbits % unit) stream.write_bits(v.words[full], Size_t(nbits % unit));
+			return stream;
+		}
+		/// @brief lecture de n valeurs à partir du curseur de lecture du flux (qui avance).
+		/// @detail retourne le nombre de valeurs complètes lues; les valeurs manquantes valent 0.
+		size_t read(Stream &stream, size_t n) {
+			resize(n);
+			const size_t  nbits = n * width(), full = nbits / unit;
+			const Size_t  avail = stream.get_bit_size() - stream.getReadPosition().LastBit();
+			for(size_t k=0;k<full;++k) words[k] = stream.get_bits(unit);
+			if (nbits % unit) words[full] = stream.get_bits(Size_t(nbits % unit));
+			return std::min(n, size_t(avail) / width());
+		}
+
+		friend bool operator==(const BasicPackedVector &a, const BasicPackedVector &b) {
+			return (a.width() == b.width()) && (a.count == b.count) && (a.words.size() == b.words.size())
+				&& std::equal(a.words.begin(), a.words.end(), b.words.begin());
+		}
+		friend bool operator!=(const BasicPackedVector &a, const BasicPackedVector &b) { return !(a == b); }
+
+	protected:
+		size_t						count;	///< nombre de valeurs
+		std::vector<storage_type>	words;	///< nwords(count) mots de données + Padding mots nuls
+
+		inline size_t nwords(size_t n) const { return (n * width() + unit - 1) / unit; }
+		/// n bits (1 à 64) à partir du bit p, le premier bit étant le bit 0 du résultat
+		inline uint64_t load(size_t p, Size_t n) const {
+			const size_t  k = p / unit, o = p % unit;
+			uint64_t  v = (uint64_t(words[k]) | (uint64_t(words[k+1]) << unit)) >> o;
+			if (o + n > 64) v |= uint64_t(words[k+2]) << (64 - o);
+			return (n == 64) ? v : v & ((uint64_t(1) << n) - 1);
+		}
+		/// écrit les n bits (1 à 64) de poids faible de x à partir du bit p
+		inline void store(size_t p, Size_t n, uint64_t x) {
+			const size_t  k = p / unit, o = p % unit;
+			const uint64_t  m = (n == 64) ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+			x &= m;
+			uint64_t  w = uint64_t(words[k]) | (uint64_t(words[k+1]) << unit);
+			w = (w & ~(m << o)) | (x << o);
+			words[k] = storage_type(w);
+			words[k+1] = storage_type(w >> unit);
+			if (o + n > 64) {
+				const Size_t  r = Size_t(o + n - 64);
+				words[k+2] = storage_type((words[k+2] & ~mask<storage_type>(0, r)) | (x >> (64 - o)));
+			}
+		}
+	};
+
+	/// tableau de valeurs de NBITS bits
+	template <int NBITS> using PackedVector = BasicPackedVector<FixedWidth<NBITS>>;
+
+	/// tableau de valeurs dont le nombre de bits est fixé à la construction
+	class varPackedVector : public BasicPackedVector<VarWidth> {
+	public:
+		explicit varPackedVector(Size_t nbits = 64) : BasicPackedVector(VarWidth(nbits)) {}
+		varPackedVector(Size_t nbits, size_t n, value_type x = 0) : BasicPackedVector(n, x, VarWidth(nbits)) {}
+		varPackedVector(Size_t nbits, const Stream &stream, size_t n, Size_t from = 0)
+			: BasicPackedVector(stream, n, from, VarWidth(nbits)) {}
+		/// sinon, l'opérateur << générique de BitStream.h (écriture de l'objet brut) serait choisi
+		friend Stream& operator<<(Stream &stream, const varPackedVector &v) {
+			return stream << static_cast<const BasicPackedVector&>(v);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,227 @@
+/// library: bitstream / BitParallel.h (décodage parallèle)
+/// + Bits::parallel_run : exécution d'une fonction dans n threads.
+/// + Bits::CParallelHuffman : décodage de Huffman d'un flux unique réparti sur plusieurs threads,
+///   soit par auto-synchronisation des codes de Huffman (format de Bits::CHuffman inchangé), soit à
+///   l'aide d'une table des écarts optionnelle écrite par le codeur (longueur en bits de chaque
+///   segment de symboles).
+
+#ifndef _BITPARALLEL
+#define _BITPARALLEL
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitCodec.h"
+
+namespace Bits {
+	/// nombre de threads par défaut (nombre de coeurs)
+	inline Size_t default_threads() {
+		const Size_t  n = std::thread::hardware_concurrency();
+		return n ? n : 1;
+	}
+	/// @brief exécute f(t) pour t = 0..n-1, chacun dans son thread (f(0) dans le thread appelant).
+	template <class F> void parallel_run(Size_t n, F f) {
+		std::vector<std::thread>  pool;
+		for(Size_t t=1;t<n;++t) pool.emplace_back(f, t);
+		if (n) f(0);
+		for(auto &th : pool) th.join();
+	}
+
+	/// class Bits::CParallelHuffman
+	/// format: présence de la table des écarts (1 bit), table éventuelle, puis un bloc Bits::CHuffman.
+	/// table des écarts: nombre de symboles par segment (32 bits), largeur w (6 bits), puis la longueur
+	/// en bits des codes de chaque segment (w bits chacune). Chaque thread décode alors ses segments à
+	/// partir de leur position exacte.
+	/// Sans table (ou avec decode_huffman sur un bloc Bits::CHuffman), les codes sont découpés en
+	/// intervalles de bits égaux, un par thread, jusqu'à la fin du bloc si elle est connue, sinon du flux.
+	/// Chacun est décodé à partir d'une position quelconque: un code de Huffman se resynchronise en
+	/// général au bout de quelques symboles. Le thread t prolonge ensuite son décodage dans l'intervalle
+	/// t+1 jusqu'à tomber sur un début de code trouvé par le thread t+1: les symboles de t+1 sont exacts
+	/// à partir de ce point. Si la synchronisation échoue, le bloc est décodé séquentiellement.
+	class CParallelHuffman : public CHuffman {
+	public:
+		enum Constants : Size_t {
+			MinChunkBits = 1u << 17,	///< plus petit intervalle de bits décodé par un thread sans table
+			SyncBounds = 1024,			///< débuts de codes conservés pour la synchronisation
+			MarkRate = 256				///< un début de code mémorisé tous les MarkRate symboles
+		};
+
+		/// @param threads nombre de threads du décodage (0 = nombre de coeurs)
+		/// @param interval nombre de symboles par segment de la table des écarts (0 = pas de table)
+		explicit CParallelHuffman(Size_t threads = 0, Size_t interval = 1u << 16)
+			: threads(threads ? threads : default_threads()), interval(interval) {
+			BITS_ASSERT( (interval < (1u << 28)) && "CParallelHuffman: segments trop longs");
+		}
+
+		uint32_t magic() const override { return Magic('H','U','P','0'); }
+		const char *name() const override { return "ParallelHuffman"; }
+		uint64_t cost(const Histogram &h) const override {
+			const uint64_t  segments = interval ? (uint64_t(h.total) + interval - 1) / interval : 0;
+			return 1 + CHuffman::cost(h) + (interval ? 38 + segments*MSB(uint64_t(interval)*MaxLength) : 0);
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			encode(data, n, Histogram(data, n), out);
+		}
+		/// @brief codage avec un histogramme déjà calculé
+		void encode(const Byte *data, Size_t n, const Histogram &h, Stream &out) {
+			out.write_bits(interval != 0, 1);
+			if (interval) {
+				const Lengths		 len = lengths(h);
+				std::vector<Size_t>  bits((n + interval - 1) / interval, 0);
+				for(Size_t i=0;i<n;++i) bits[i / interval] += len[data[i]];
+				const Size_t  w = bits.empty() ? 0 : MSB(*std::max_element(bits.begin(), bits.end()));
+				out.write_bits(interval, 32);
+				out.write_bits(w, 6);
+				if (w) for(Size_t b : bits) out.write_bits(b, w);
+			}
+			CHuffman::encode(data, n, h, out);
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			gaps.clear();
+			if (in.get_bits(1)) {
+				step = in.get_bits(32);
+				const Size_t  w = in.get_bits(6);
+				if ((step == 0) || (w > 32)) return false;
+				const Size_t  segments = n ? (n - 1) / step + 1 : 0;
+				if (in.get_bit_size() - in.getReadPosition().LastBit() < uint64_t(segments)*w) return false;
+				gaps.resize(segments);
+				for(auto &g : gaps) g = w ? in.get_bits(w) : 0;
+			}
+			return decode_block(in, data, n);
+		}
+		/// @brief décodage parallèle d'un bloc au format de Bits::CHuffman (par auto-synchronisation).
+		/// @param end position (bit) de la fin du bloc si d'autres données le suivent, 0 si elle est
+		/// inconnue: les intervalles vont alors jusqu'à la fin du flux (n codes de MaxLength bits au plus)
+		bool decode_huffman(Stream &in, Byte *data, Size_t n, Size_t end = 0) {
+			gaps.clear();
+			return decode_block(in, data, n, end);
+		}
+
+	protected:
+		Size_t				 threads, interval;
+		Size_t				 step = 0;	///< nombre de symboles par segment de la table lue
+		std::vector<Size_t>	 gaps;		///< table des écarts lue (vide si absente)
+
+		/// symboles décodés par un thread à partir d'une position quelconque
+		struct Part {
+			std::vector<Byte>	 symbols;
+			std::vector<Size_t>	 bounds;	///< positions des SyncBounds premiers codes
+			std::vector<Size_t>	 marks;		///< position du code d'indice k*MarkRate
+			Size_t				 stop = 0;	///< position après le dernier code décodé
+			Size_t				 skip = 0;	///< nombre de symboles erronés avant la synchronisation
+			bool				 ok = true, synced = true;
+		};
+
+		/// MaxLength bits à partir du bit p (0 au-delà de end)
+		inline Size_t peek(const Stream &in, Size_t p, Size_t end) const {
+			if (p + 64 <= end) {
+				const Stream::storage_type  *w = in.get_data() + p / 32;
+				return Size_t(((uint64_t(w[0]) | (uint64_t(w[1]) << 32)) >> (p % 32)) & ((1u << MaxLength) - 1));
+			}
+			return (p < end) ? in.read_bits(p, std::min(end - p, Size_t(MaxLength))) : 0;
+		}
+
+		/// @brief place le curseur de lecture au bit p (après la fin du bloc décodé). seek refuse la fin
+		/// du flux, qui est le cas courant: le curseur est donc avancé par skip_bits.
+		/// Retourne faux si p est avant le curseur ou après la fin du flux.
+		static inline bool advance(Stream &in, Size_t p) {
+			const Size_t  r = in.getReadPosition().LastBit();
+			if ((p < r) || (p > in.get_bit_size())) return false;
+			in.skip_bits(p - r);
+			return true;
+		}
+
+		bool decode_block(Stream &in, Byte *data, Size_t n, Size_t end = 0) {
+			if (!read_table(in)) return false;
+			if (n == 0) return true;
+			return gaps.empty() ? decode_sync(in, data, n, end) : decode_gaps(in, data, n);
+		}
+
+		/// décodage des segments de la table des écarts, répartis entre les threads
+		bool decode_gaps(Stream &in, Byte *data, Size_t n) {
+			const Size_t  end = in.get_bit_size();
+			std::vector<uint64_t>  start(gaps.size() + 1, in.getReadPosition().LastBit());
+			for(size_t k=0;k<gaps.size();++k) start[k+1] = start[k] + gaps[k];
+			if (start.back() > end) return false;
+			const Size_t  T = std::min(threads, Size_t(gaps.size()));
+			std::vector<Byte>  ok(T, 1);
+			parallel_run(T, [&](Size_t t) {
+				for(Size_t k=t;k<gaps.size();k+=T) {
+					Size_t  p = Size_t(start[k]);
+					const Size_t  first = k*step, last = first + std::min(step, n - first);
+					for(Size_t i=first;i<last;++i) {
+						const uint16_t  e = tab[peek(in, p, end)];
+						if (e == 0) { ok[t] = 0; return; }
+						data[i] = Byte(e & 0xFF);
+						p += e >> 8;
+					}
+					if (p != start[k+1]) { ok[t] = 0; return; }
+				}
+			});
+			return advance(in, Size_t(start.back())) && (std::find(ok.begin(), ok.end(), 0) == ok.end());
+		}
+
+		/// @brief décodage par auto-synchronisation (cf description de la classe) des codes compris
+		/// entre le curseur de lecture et block_end (0: fin du flux).
+		bool decode_sync(Stream &in, Byte *data, Size_t n, Size_t block_end) {
+			const Size_t  b0 = in.getReadPosition().LastBit(), size = in.get_bit_size();
+			const Size_t  end = Size_t(std::min(uint64_t((block_end && (block_end < size)) ? block_end : size), b0 + uint64_t(n)*MaxLength));
+			if (end < b0) return false;
+			const Size_t  T = std::min(threads, (end - b0) / MinChunkBits);
+			if (T < 2) return decode_symbols(in, data, n) && (in.getReadPosition().LastBit() <= end);
+			const auto  limit = [&](Size_t t) { return Size_t(b0 + uint64_t(end - b0)*t/T); };
+			std::vector<Part>  parts(T);
+			// 1. décodage de chaque intervalle à partir de son premier bit
+			parallel_run(T, [&](Size_t t) {
+				Part	&part = parts[t];
+				Size_t	p = limit(t);
+				const Size_t  stop = limit(t + 1);
+				while ((p < stop) && (part.symbols.size() < n)) {
+					if (part.bounds.size() < SyncBounds) part.bounds.push_back(p);
+					if (part.symbols.size() % MarkRate == 0) part.marks.push_back(p);
+					const uint16_t  e = tab[peek(in, p, end)];
+					if (e == 0) { part.ok = false; break; }
+					part.symbols.push_back(Byte(e & 0xFF));
+					p += e >> 8;
+				}
+				part.stop = p;
+			});
+			// 2. prolongement de chaque intervalle jusqu'à un début de code de l'intervalle suivant
+			parallel_run(T - 1, [&](Size_t t) {
+				Part	&part = parts[t], &next = parts[t + 1];
+				next.synced = false;
+				if (!part.ok) return;
+				Size_t	p = part.stop, j = 0;
+				for(;;) {
+					while ((j < next.bounds.size()) && (next.bounds[j] < p)) ++j;
+					if (j == next.bounds.size()) return;
+					if (next.bounds[j] == p) { next.skip = j; next.synced = true; return; }
+					if (part.symbols.size() % MarkRate == 0) part.marks.push_back(p);
+					const uint16_t  e = tab[peek(in, p, end)];
+					if (e == 0) return;
+					part.symbols.push_back(Byte(e & 0xFF));
+					p += e >> 8;
+				}
+			});
+			// 3. assemblage des symboles exacts; la fin du bloc est retrouvée depuis la marque précédente
+			Size_t  off = 0;
+			for(Size_t t=0;(t < T) && parts[t].synced;++t) {
+				const Part	 &part = parts[t];
+				const Size_t  take = std::min(Size_t(part.symbols.size()) - part.skip, n - off);
+				memcpy(data + off, part.symbols.data() + part.skip, take);
+				off += take;
+				if (off < n) continue;
+				const Size_t  local = part.skip + take;
+				const Size_t  m = std::min(local / MarkRate, Size_t(part.marks.size()) - 1);
+				Size_t  p = part.marks[m];
+				for(Size_t i=m*MarkRate;i<local;++i) p += Size_t(tab[peek(in, p, end)] >> 8);
+				return (p <= end) && advance(in, p);
+			}
+			// synchronisation impossible: décodage séquentiel
+			return decode_symbols(in, data, n) && (in.getReadPosition().LastBit() <= end);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,141 @@
+/// library: bitstream / BitRank.h (index rank/select sur un flux)
+/// + Bits::RankSelect : index en lecture seule construit sur un Bits::Stream terminé, qui répond
+///   à access(i), rank1(i)/rank0(i) et select1(k)/select0(k) sans relire le flux bit à bit.
+/// + annuaire des nombres de 1 sur deux niveaux (super-blocs de 2^16 bits, blocs de 512 bits) et
+///   positions échantillonnées des 1 et des 0 (un sur 4096): environ 4% de la taille du flux
+///   pour une densité de 1/2.
+
+#ifndef _BITRANK
+#define _BITRANK
+#include <cstdint>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+
+namespace Bits {
+	/// class Bits::RankSelect
+	/// L'index lit directement les mots du flux: le flux doit rester en vie et ne plus être modifié
+	/// (ni écrit, ni réalloué) tant que l'index est utilisé.
+	/// rank1(i) = nombre de 1 dans [0,i[ (O(1)); select1(k) = position du 1 de rang k, k = 0 pour le
+	/// premier (recherche dichotomique limitée à l'intervalle entre deux échantillons).
+	class RankSelect {
+	public:
+		/// tailles des niveaux de l'annuaire et pas d'échantillonnage de select (en bits / en bits à 1 ou 0)
+		enum Constants : Size_t {
+			BlockBits = 512,
+			SuperBits = 1u << 16,
+			BlocksPerSuper = SuperBits / BlockBits,
+			WordsPerBlock = BlockBits / 64,
+			SampleRate = 4096
+		};
+
+		/// construit l'index des bits [0, stream.get_bit_size()[ du flux
+		explicit RankSelect(const Stream &stream)
+			: data(stream.get_data()), nwords32(stream.get_size()), nbits(stream.get_bit_size()) {
+			const Size_t  nwords = (nbits + 63) / 64, nblocks = (nbits + BlockBits - 1) / BlockBits;
+			tail = nwords ? read_word(nwords - 1) : 0;
+			if (nbits % 64) tail &= (uint64_t(1) << (nbits % 64)) - 1;
+			supers.resize(nblocks / BlocksPerSuper + 1);
+			blocks.resize(nblocks + 1);
+			Size_t  ones = 0;
+			for(Size_t b=0;b<=nblocks;++b) {
+				if (b % BlocksPerSuper == 0) supers[b / BlocksPerSuper] = ones;
+				blocks[b] = uint16_t(ones - supers[b / BlocksPerSuper]);
+				if (b == nblocks) break;
+				// échantillons: bloc contenant le 1 (resp. le 0) de rang multiple de SampleRate
+				Size_t  n = 0;
+				for(Size_t w=b*WordsPerBlock;(w < nwords) && (w < (b + 1)*WordsPerBlock);++w) n += PopCount(word(w));
+				const Size_t  start = b*BlockBits, len = std::min(Size_t(BlockBits), nbits - start);
+				const Size_t  zeros = start - ones, nzeros = len - n;
+				while (Size_t(samples1.size())*SampleRate < ones + n) samples1.push_back(b);
+				while (Size_t(samples0.size())*SampleRate < zeros + nzeros) samples0.push_back(b);
+				ones += n;
+			}
+			total = ones;
+		}
+
+		/// nombre de bits indexés et nombre de bits à 1
+		inline Size_t size() const { return nbits; }
+		inline Size_t ones() const { return total; }
+		inline Size_t zeros() const { return nbits - total; }
+		/// taille de l'index (octets)
+		inline size_t memory() const {
+			return supers.size()*sizeof(uint32_t) + blocks.size()*sizeof(uint16_t)
+				+ (samples1.size() + samples0.size())*sizeof(Size_t);
+		}
+
+		/// valeur du bit i (i < size())
+		inline Bit access(Size_t i) const {
+			BITS_ASSERT( (i < nbits) && "RankSelect: position hors du flux");
+			return Bit((data[i / 32] >> (i % 32)) & 1u);
+		}
+		/// nombre de bits à 1 dans [0,i[ (i <= size())
+		inline Size_t rank1(Size_t i) const {
+			BITS_ASSERT( (i <= nbits) && "RankSelect: position hors du flux");
+			const Size_t  b = i / BlockBits, end = i / 64;
+			Size_t  r = block_rank(b);
+			for(Size_t w=b*WordsPerBlock;w<end;++w) r += PopCount(word(w));
+			if (i % 64) r += PopCount(word(end) & ((uint64_t(1) << (i % 64)) - 1));
+			return r;
+		}
+		/// nombre de bits à 0 dans [0,i[ (i <= size())
+		inline Size_t rank0(Size_t i) const { return i - rank1(i); }
+
+		/// position du bit à 1 de rang k (k < ones())
+		Size_t select1(Size_t k) const {
+			BITS_ASSERT( (k < total) && "RankSelect: rang au-delà du nombre de 1");
+			Size_t  b = find_block(samples1, k, [this](Size_t x) { return block_rank(x); });
+			k -= block_rank(b);
+			for(Size_t w=b*WordsPerBlock;;++w) {
+				const uint64_t  v = word(w);
+				const Size_t	n = PopCount(v);
+				if (k < n) return w*64 + Select(v, k);
+				k -= n;
+			}
+		}
+		/// position du bit à 0 de rang k (k < zeros())
+		Size_t select0(Size_t k) const {
+			BITS_ASSERT( (k < nbits - total) && "RankSelect: rang au-delà du nombre de 0");
+			Size_t  b = find_block(samples0, k, [this](Size_t x) { return x*BlockBits - block_rank(x); });
+			k -= b*BlockBits - block_rank(b);
+			for(Size_t w=b*WordsPerBlock;;++w) {
+				const uint64_t  v = ~word(w);
+				const Size_t	n = PopCount(v);
+				if (k < n) return w*64 + Select(v, k);
+				k -= n;
+			}
+		}
+
+	protected:
+		const Stream::storage_type	*data;			///< mots du flux indexé
+		Size_t						nwords32, nbits, total = 0;
+		uint64_t					tail;			///< dernier mot de 64 bits, bits au-delà de nbits à 0
+		std::vector<uint32_t>		supers;			///< nombre de 1 avant chaque super-bloc
+		std::vector<uint16_t>		blocks;			///< nombre de 1 avant chaque bloc, depuis son super-bloc
+		std::vector<Size_t>			samples1, samples0;	///< bloc contenant le 1 (0) de rang j*SampleRate
+
+		/// mot de 64 bits d'indice w tel qu'il est stocké dans le flux (bits 64w à 64w+63)
+		inline uint64_t read_word(Size_t w) const {
+			uint64_t  v = data[2*w];
+			if (2*w + 1 < nwords32) v |= uint64_t(data[2*w + 1]) << 32;
+			return v;
+		}
+		inline uint64_t word(Size_t w) const {
+			return (w + 1 == (nbits + 63) / 64) ? tail : read_word(w);
+		}
+		/// nombre de 1 avant le bloc b
+		inline Size_t block_rank(Size_t b) const { return supers[b / BlocksPerSuper] + blocks[b]; }
+		/// dernier bloc b tel que rank(b) <= k, entre les échantillons qui encadrent k
+		template <class Rank> Size_t find_block(const std::vector<Size_t> &samples, Size_t k, Rank rank) const {
+			const Size_t  s = k / SampleRate;
+			Size_t  lo = samples[s], hi = (s + 1 < samples.size()) ? samples[s + 1] + 1 : Size_t(blocks.size() - 1);
+			while (hi - lo > 1) {
+				const Size_t  mid = lo + (hi - lo) / 2;
+				if (rank(mid) <= k) lo = mid; else hi = mid;
+			}
+			return lo;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,218 @@
+/// library: bitstream / BitRecord.h (enregistrements de champs de largeurs fixées à la compilation)
+/// + Bits::Record<Field<3>, Field<5>, Field<12>, ...> : schéma d'enregistrement dont les positions des
+///   champs sont calculées à la compilation.
+/// + écriture/lecture d'un enregistrement ou d'un tableau d'enregistrements dans un Bits::Stream, par
+///   mots de 32 bits entiers (les champs sont regroupés avant écriture).
+/// + lecture d'un tableau d'enregistrements en colonnes (un std::vector par champ).
+/// + les bits sont rangés comme si chaque champ avait été écrit par stream << Block<N>(v) (MSB en
+///   premier): le format est celui des suites de Bits::Block déjà écrites.
+
+#ifndef _BITRECORD
+#define _BITRECORD
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include "BitBase.h"
+#include "BitBlock.h"
+#include "BitStream.h"
+
+namespace Bits {
+	/// champ de NBITS bits (1 à 64)
+	template <int NBITS> struct Field {
+		static_assert((NBITS >= 1) && (NBITS <= 64), "Field: 1 à 64 bits par champ");
+		using type = typename Block<NBITS>::Type;
+		static constexpr Size_t bits = Size_t(NBITS);
+	};
+
+	/// classes techniques: suite d'indices 0..N-1 (std::index_sequence n'existe qu'à partir de C++14),
+	/// somme des largeurs des champs
+	template <Size_t... I> struct FieldIndices {};
+	template <Size_t N, Size_t... I> struct MakeFieldIndices : MakeFieldIndices<N - 1, N - 1, I...> {};
+	template <Size_t... I> struct MakeFieldIndices<0, I...> { using type = FieldIndices<I...>; };
+	template <class... F> struct FieldBits;
+	template <> struct FieldBits<> { static constexpr Size_t value = 0; };
+	template <class F, class... R> struct FieldBits<F, R...> { static constexpr Size_t value = F::bits + FieldBits<R...>::value; };
+
+	/// class Bits::BitPacker
+	/// accumulateur des champs écrits MSB en premier: les bits sont ajoutés par la droite et chaque
+	/// paquet de 32 bits complet est écrit dans le flux en une fois (retourné pour l'ordre du flux).
+	class BitPacker {
+	public:
+		explicit BitPacker(Stream &out) : out(out) {}
+		~BitPacker() { flush(); }
+		/// ajoute les w bits de poids faible de v (w constant après mise en ligne)
+		inline void put(uint64_t v, Size_t w) {
+			if (w > 32) {
+				put32(v >> 32, w - 32);
+				put32(v, 32);
+			} else put32(v, w);
+		}
+		/// écrit les bits en attente
+		inline void flush() {
+			if (fill) out.write_bits(Stream::storage_type(Reverse<uint64_t>(acc, fill)), fill);
+			fill = 0;
+		}
+	protected:
+		Stream		&out;
+		uint64_t	acc = 0;	///< bits en attente dans les fill bits de poids faible (les plus anciens en tête)
+		Size_t		fill = 0;	///< nombre de bits en attente (< 32)
+		inline void put32(uint64_t v, Size_t w) {
+			acc = (acc << w) | (v & ((uint64_t(1) << w) - 1));
+			fill += w;
+			if (fill >= 32) {
+				fill -= 32;
+				out.write_bits(Reverse<uint32_t>(uint32_t(acc >> fill)), 32);
+			}
+		}
+	};
+
+	/// class Bits::BitUnpacker
+	/// lecture symétrique de Bits::BitPacker: le flux est lu par mots de 32 bits. A la destruction
+	/// (ou par finish), le curseur de lecture est replacé juste après le dernier champ lu.
+	class BitUnpacker {
+	public:
+		explicit BitUnpacker(Stream &in) : in(in) {}
+		~BitUnpacker() { finish(); }
+		/// w bits suivants (w constant après mise en ligne); 0 et valid() faux au-delà du flux
+		inline uint64_t get(Size_t w) {
+			if (w > 32) {
+				const uint64_t  high = get32(w - 32);
+				return (high << 32) | get32(32);
+			}
+			return get32(w);
+		}
+		/// faux si la lecture a dépassé la fin du flux
+		inline bool valid() const { return ok; }
+		/// rend au flux les bits lus d'avance
+		inline void finish() {
+			if (avail) in.seek(in.getReadPosition().LastBit() - avail);
+			avail = 0;
+		}
+	protected:
+		Stream		&in;
+		uint64_t	acc = 0;	///< bits lus d'avance dans les avail bits de poids faible (les plus anciens en tête)
+		Size_t		avail = 0;
+		bool		ok = true;
+		inline uint64_t get32(Size_t w) {
+			if (avail < w) {
+				const Size_t  r = std::min(Size_t(32), in.get_bit_size() - in.getReadPosition().LastBit());
+				if (r) {
+					acc = (acc << r) | Reverse<uint64_t>(in.get_bits(r), r);
+					avail += r;
+				}
+				if (avail < w) { ok = false; avail = 0; return 0; }
+			}
+			avail -= w;
+			return (acc >> avail) & ((uint64_t(1) << w) - 1);
+		}
+	};
+
+	/// class Bits::Record
+	/// Les champs sont rangés dans l'ordre de la liste, le champ I occupant les bits
+	/// [offset<I>(), offset<I>() + width<I>()[ de l'enregistrement. Un tableau d'enregistrements est
+	/// écrit sans bit perdu entre enregistrements.
+	template <class... Fields> class Record {
+		static_assert(sizeof...(Fields) > 0, "Record: au moins un champ");
+	public:
+		/// nombre de champs et taille d'un enregistrement (bits)
+		static constexpr Size_t count = Size_t(sizeof...(Fields));
+		static constexpr Size_t bits = FieldBits<Fields...>::value;
+		/// type du champ I
+		template <Size_t I> using field = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+		/// valeurs d'un enregistrement et colonnes d'un tableau d'enregistrements
+		using Values = std::tuple<typename Fields::type...>;
+		using Columns = std::tuple<std::vector<typename Fields::type>...>;
+
+		/// largeur et position (en bits, depuis le début de l'enregistrement) du champ I
+		template <Size_t I> static constexpr Size_t width() { return field<I>::bits; }
+		template <Size_t I> static constexpr Size_t offset() { return offset_of(I, Sizes{{Fields::bits...}}); }
+
+		/// enregistrement nul
+		Record() : values() {}
+		/// enregistrement de valeurs données (les bits au-delà de la largeur de chaque champ ne sont pas écrits)
+		explicit Record(typename Fields::type... v) : values(v...) {}
+
+		/// valeur du champ I
+		template <Size_t I> inline typename field<I>::type get() const { return std::get<I>(values); }
+		template <Size_t I> inline void set(typename field<I>::type v) { std::get<I>(values) = v; }
+		inline const Values& tuple() const { return values; }
+
+		/// @brief écriture d'un enregistrement (bits/32 mots entiers au plus, plus un mot partiel)
+		friend Stream& operator<<(Stream &stream, const Record &r) {
+			BitPacker  p(stream);
+			r.put(p, Indices());
+			return stream;
+		}
+		/// @brief lecture d'un enregistrement. Retourne faux (enregistrement inchangé) si le flux est trop court.
+		friend bool operator>>(Stream &stream, Record &r) {
+			if (stream.get_bit_size() - stream.getReadPosition().LastBit() < bits) return false;
+			BitUnpacker  u(stream);
+			r.take(u, Indices());
+			return true;
+		}
+
+		/// @brief écriture de n enregistrements à la suite
+		static void write(Stream &stream, const Record *r, size_t n) {
+			BitPacker  p(stream);
+			for(size_t k=0;k<n;++k) r[k].put(p, Indices());
+		}
+		static void write(Stream &stream, const std::vector<Record> &r) { write(stream, r.data(), r.size()); }
+		/// @brief écriture d'enregistrements donnés par colonnes (toutes de même taille)
+		static void write(Stream &stream, const Columns &c) {
+			BitPacker	  p(stream);
+			const size_t  n = std::get<0>(c).size();
+			for(size_t k=0;k<n;++k) put_row(p, c, k, Indices());
+		}
+		/// @brief lecture de n enregistrements
+		static bool read(Stream &stream, size_t n, std::vector<Record> &r) {
+			if (!available(stream, n)) return false;
+			r.resize(n);
+			BitUnpacker  u(stream);
+			for(size_t k=0;k<n;++k) r[k].take(u, Indices());
+			return true;
+		}
+		/// @brief lecture de n enregistrements en colonnes: std::get<I>(c)[k] est le champ I de l'enregistrement k.
+		/// Retourne faux (colonnes inchangées) si le flux est trop court.
+		static bool read(Stream &stream, size_t n, Columns &c) {
+			if (!available(stream, n)) return false;
+			resize(c, n, Indices());
+			BitUnpacker  u(stream);
+			for(size_t k=0;k<n;++k) take_row(u, c, k, Indices());
+			return true;
+		}
+
+	protected:
+		using Indices = typename MakeFieldIndices<count>::type;
+		struct Sizes { Size_t w[count]; };
+		Values  values;
+
+		static constexpr Size_t offset_of(Size_t i, Sizes s) { return i ? s.w[i - 1] + offset_of(i - 1, s) : 0; }
+		static bool available(const Stream &stream, size_t n) {
+			return uint64_t(stream.get_bit_size() - stream.getReadPosition().LastBit()) >= uint64_t(n) * bits;
+		}
+
+		// chaque opération est développée champ par champ (liste d'initialisation: évaluation dans l'ordre)
+		template <Size_t... I> inline void put(BitPacker &p, FieldIndices<I...>) const {
+			const int  expand[] = { 0, (p.put(uint64_t(std::get<I>(values)), width<I>()), 0)... };
+			(void)expand;
+		}
+		template <Size_t... I> inline void take(BitUnpacker &u, FieldIndices<I...>) {
+			const int  expand[] = { 0, (std::get<I>(values) = typename field<I>::type(u.get(width<I>())), 0)... };
+			(void)expand;
+		}
+		template <Size_t... I> static inline void put_row(BitPacker &p, const Columns &c, size_t k, FieldIndices<I...>) {
+			const int  expand[] = { 0, (p.put(uint64_t(std::get<I>(c)[k]), width<I>()), 0)... };
+			(void)expand;
+		}
+		template <Size_t... I> static inline void take_row(BitUnpacker &u, Columns &c, size_t k, FieldIndices<I...>) {
+			const int  expand[] = { 0, (std::get<I>(c)[k] = typename field<I>::type(u.get(width<I>())), 0)... };
+			(void)expand;
+		}
+		template <Size_t... I> static void resize(Columns &c, size_t n, FieldIndices<I...>) {
+			const int  expand[] = { 0, (std::get<I>(c).resize(n), 0)... };
+			(void)expand;
+		}
+	};
+}
+
+#endif
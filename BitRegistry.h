@@ -0,0 +1,293 @@
+/// library: bitstream / BitRegistry.h (tables de codage partagées entre messages)
+/// + Bits::Model : table de codage (taille fixe ou Huffman) construite une fois à partir d'un
+///   histogramme (éventuellement d'un échantillon), avec ses tables de codage et de décodage.
+/// + Bits::ModelRegistry : ensemble de modèles identifiés par un numéro court (et retrouvés par
+///   l'empreinte de leur table), partagé par le codeur et le décodeur; écriture/relecture dans un flux.
+/// + Bits::CRegistered : codeur de messages dont l'entête ne contient que le numéro du modèle.
+
+#ifndef _BITREGISTRY
+#define _BITREGISTRY
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitChecksum.h"
+#include "BitCodec.h"
+
+namespace Bits {
+	/// class Bits::Model
+	/// FixedWidth: table des symboles de l'histogramme, codes de Bits::CTF (un message ne peut contenir
+	/// que ces symboles, cf covers). Entropy: longueurs des codes de Bits::CHuffman, calculées sur un
+	/// histogramme où les 256 octets sont présents (les absents avec un poids minimal), de sorte que
+	/// tout message peut être codé.
+	/// Les tables (codes, décodage) sont construites une fois; encode/decode sont constantes et peuvent
+	/// être utilisées par plusieurs threads.
+	class Model {
+	public:
+		enum Kind : Size_t { FixedWidth = 0, Entropy = 1 };
+
+		/// modèle vide (avant read)
+		Model() = default;
+		/// @brief modèle de l'histogramme h
+		explicit Model(const Histogram &h, Kind kind = Entropy) : type(kind) {
+			if (kind == FixedWidth) {
+				for(Size_t s=0;s<256;++s) if (h.count[s]) symbol[k++] = Byte(s);
+				if (k == 0) symbol[k++] = 0;
+			} else {
+				// effectifs mis à l'échelle de 2^20 au moins, puis poids 1 pour les octets absents
+				Histogram	 full;
+				const Size_t  f = std::max(Size_t(1), (1u << 20) / std::max(Size_t(1), h.total));
+				for(Size_t s=0;s<256;++s) full.count[s] = h.count[s] ? h.count[s]*f : 1;
+				len = CHuffman::lengths(full);
+			}
+			build();
+		}
+
+		inline Kind kind() const { return type; }
+		/// empreinte de la table (CRC-32C de sa forme écrite): identique pour deux tables identiques
+		inline uint32_t fingerprint() const { return hash; }
+		/// vrai si tous les octets de data ont un code
+		bool covers(const Byte *data, Size_t n) const {
+			if (complete) return true;
+			for(Size_t i=0;i<n;++i) if (code[data[i]] == NoCode) return false;
+			return true;
+		}
+		/// @brief coût en bits des codes d'un message d'histogramme h (entête non compris; ~0 si non couvert).
+		uint64_t cost(const Histogram &h) const {
+			uint64_t  c = 0;
+			for(Size_t s=0;s<256;++s) {
+				if (!h.count[s]) continue;
+				if (code[s] == NoCode) return ~uint64_t(0);
+				c += uint64_t(type == Entropy ? len[s] : width)*h.count[s];
+			}
+			return c;
+		}
+		/// @brief codes des n octets de data (covers(data, n) doit être vrai).
+		void encode(const Byte *data, Size_t n, Stream &out) const {
+			BITS_ASSERT( covers(data, n) && "Model: symbole absent de la table" );
+			if (type == Entropy) for(Size_t i=0;i<n;++i) out.write_bits(code[data[i]], len[data[i]]);
+			else if (width) for(Size_t i=0;i<n;++i) out.write_bits(code[data[i]], width);
+		}
+		/// @brief décode n octets au curseur de lecture. Retourne faux si un code est invalide.
+		bool decode(Stream &in, Byte *data, Size_t n) const {
+			if (type == Entropy) {
+				for(Size_t i=0;i<n;++i) {
+					const uint16_t  e = tab[in.peek_bits(CHuffman::MaxLength)];
+					if (e == 0) return false;
+					data[i] = Byte(e & 0xFF);
+					in.skip_bits(e >> 8);
+				}
+				return true;
+			}
+			for(Size_t i=0;i<n;++i) {
+				const Size_t  c = width ? in.get_bits(width) : 0;
+				if (c >= k) return false;
+				data[i] = symbol[c];
+			}
+			return true;
+		}
+
+		/// @brief écriture de la table: type (1 bit), puis longueurs (4 bits x 256) ou table de CTF.
+		friend Stream& operator<<(Stream &stream, const Model &m) {
+			stream.write_bits(m.type, 1);
+			if (m.type == Entropy) for(Size_t s=0;s<256;++s) stream.write_bits(m.len[s], 4);
+			else {
+				stream.write_bits(m.k - 1, 8);
+				for(Size_t i=0;i<m.k;++i) stream.write_bits(m.symbol[i], 8);
+			}
+			return stream;
+		}
+		/// @brief relecture à partir du curseur de lecture. Retourne faux (modèle inchangé) si la table
+		/// est incomplète ou invalide.
+		bool read(Stream &stream) {
+			const auto  remaining = [&stream]() { return uint64_t(stream.get_bit_size() - stream.getReadPosition().LastBit()); };
+			if (remaining() < 9) return false;
+			Model  m;
+			m.type = Kind(stream.get_bits(1));
+			if (m.type == Entropy) {
+				if (remaining() < 4*256) return false;
+				for(Size_t s=0;s<256;++s) m.len[s] = Byte(stream.get_bits(4));
+			} else {
+				m.k = stream.get_bits(8) + 1;
+				if (remaining() < 8*m.k) return false;
+				for(Size_t i=0;i<m.k;++i) m.symbol[i] = Byte(stream.get_bits(8));
+				for(Size_t i=1;i<m.k;++i) if (m.symbol[i] <= m.symbol[i-1]) return false;
+			}
+			if (!m.build()) return false;
+			*this = std::move(m);
+			return true;
+		}
+
+	protected:
+		enum : uint32_t { NoCode = ~uint32_t(0) };
+		Kind					type = Entropy;
+		CHuffman::Lengths		len{};				///< Entropy: longueur des codes
+		Byte					symbol[256] = {};	///< FixedWidth: symboles de la table
+		Size_t					k = 0, width = 0;	///< FixedWidth: nombre de symboles et largeur des codes
+		std::array<uint32_t, 256>	code{};			///< code de chaque octet (NoCode s'il est absent)
+		std::vector<uint16_t>	tab;				///< Entropy: table de décodage
+		bool					complete = false;	///< vrai si les 256 octets ont un code
+		uint32_t				hash = 0;
+
+		/// tables de codage/décodage et empreinte; faux si les longueurs ne forment pas un code préfixe
+		bool build() {
+			if (type == Entropy) {
+				if (!CHuffman::table(len, tab)) return false;
+				code = CHuffman::codes(len);
+				for(Size_t s=0;s<256;++s) if (!len[s]) code[s] = NoCode;
+			} else {
+				code.fill(NoCode);
+				for(Size_t i=0;i<k;++i) code[symbol[i]] = i;
+				width = CTF::width(k);
+			}
+			complete = std::find(code.begin(), code.end(), uint32_t(NoCode)) == code.end();
+			Stream  s;
+			s << *this;
+			hash = CRC32C::of(s.get_data(), s.get_byte_size());
+			return true;
+		}
+	};
+
+	/// class Bits::ModelRegistry
+	/// Les modèles sont numérotés dans l'ordre de leur ajout; un modèle dont l'empreinte est déjà
+	/// présente n'est pas ajouté une seconde fois (son numéro est retourné). Codeur et décodeur doivent
+	/// avoir les mêmes modèles dans le même ordre: les construire de la même façon, ou écrire le
+	/// registre du codeur dans un flux et le relire côté décodeur.
+	/// Le registre ne doit plus être modifié pendant qu'il est utilisé par des codeurs.
+	class ModelRegistry {
+	public:
+		using Id = Size_t;
+		/// numéro retourné par find en l'absence de modèle
+		static constexpr Id npos = ~Id(0);
+
+		/// @brief ajoute (ou retrouve) le modèle de l'histogramme h. Retourne son numéro.
+		Id add(const Histogram &h, Model::Kind kind = Model::Entropy) { return add(Model(h, kind)); }
+		/// @brief ajoute (ou retrouve) le modèle appris sur un échantillon de n octets.
+		Id train(const Byte *sample, Size_t n, Model::Kind kind = Model::Entropy) { return add(Histogram(sample, n), kind); }
+		/// @brief ajoute (ou retrouve) le modèle m.
+		Id add(Model &&m) {
+			const auto  it = ids.find(m.fingerprint());
+			if (it != ids.end()) return it->second;
+			const Id  id = Id(models.size());
+			ids.emplace(m.fingerprint(), id);
+			models.emplace_back(new Model(std::move(m)));
+			return id;
+		}
+
+		inline Size_t size() const { return Size_t(models.size()); }
+		inline bool contains(Id id) const { return id < models.size(); }
+		inline const Model& operator[](Id id) const {
+			BITS_ASSERT( contains(id) && "ModelRegistry: modèle inconnu" );
+			return *models[id];
+		}
+		/// @brief numéro du modèle d'empreinte fingerprint (npos s'il est absent).
+		Id find(uint32_t fingerprint) const {
+			const auto  it = ids.find(fingerprint);
+			return it == ids.end() ? npos : it->second;
+		}
+		/// @brief numéro du modèle le moins coûteux pour un message d'histogramme h (npos si aucun ne le code).
+		Id best(const Histogram &h) const {
+			Id		  r = npos;
+			uint64_t  c = ~uint64_t(0);
+			for(Id id=0;id<models.size();++id) {
+				const uint64_t  m = models[id]->cost(h);
+				if (m < c) { c = m; r = id; }
+			}
+			return r;
+		}
+
+		/// @brief écriture du registre: nombre de modèles (32 bits), puis les modèles dans l'ordre.
+		friend Stream& operator<<(Stream &stream, const ModelRegistry &r) {
+			stream.write_bits(r.size(), 32);
+			for(const auto &m : r.models) stream << *m;
+			return stream;
+		}
+		/// @brief relecture (remplace le contenu). Retourne faux (registre inchangé) si les données sont invalides.
+		bool read(Stream &stream) {
+			if (stream.get_bit_size() - stream.getReadPosition().LastBit() < 32) return false;
+			ModelRegistry  r;
+			const Size_t   n = stream.get_bits(32);
+			for(Size_t i=0;i<n;++i) {
+				Model  m;
+				if (!m.read(stream)) return false;
+				// deux modèles identiques changeraient la numérotation
+				if (r.add(std::move(m)) != i) return false;
+			}
+			*this = std::move(r);
+			return true;
+		}
+
+		/// @brief écriture d'un numéro par groupes de 3 bits précédés d'un bit de continuation
+		/// (4 bits pour les 8 premiers modèles, 8 bits pour les 64 premiers...).
+		static void write_id(Stream &out, Id id) {
+			while (id >= 8) { out.write_bits(1 | ((id & 7) << 1), 4); id >>= 3; }
+			out.write_bits(id << 1, 4);
+		}
+		/// @brief relecture d'un numéro (npos si le flux est incomplet ou le numéro trop long).
+		static Id read_id(Stream &in) {
+			Id  id = 0;
+			for(Size_t shift=0;shift<32;shift+=3) {
+				if (in.get_bit_size() - in.getReadPosition().LastBit() < 4) return npos;
+				const Size_t  g = in.get_bits(4);
+				id |= (g >> 1) << shift;
+				if (!(g & 1)) return id;
+			}
+			return npos;
+		}
+
+	protected:
+		std::vector<std::unique_ptr<Model>>		models;	///< pointeurs: les modèles ne bougent pas quand le registre grandit
+		std::unordered_map<uint32_t, Id>		ids;	///< numéro de chaque empreinte
+	};
+
+	/// class Bits::CRegistered
+	/// format: numéro du modèle + 1 (ModelRegistry::write_id), puis les codes; le numéro 0 indique une
+	/// table propre au message (bloc Bits::CHuffman), utilisée si aucun modèle ne couvre le message.
+	/// Pour de petits messages, encode/decode évitent l'entête de 64 bits de compress: la taille des
+	/// messages est alors connue par ailleurs (cf Bits::Codec).
+	class CRegistered : public Codec {
+	public:
+		/// choix du modèle le moins coûteux pour chaque message
+		static constexpr ModelRegistry::Id Best = ModelRegistry::npos;
+
+		/// @param registry modèles partagés (doit rester en vie)
+		/// @param model numéro du modèle utilisé pour coder, ou Best
+		explicit CRegistered(const ModelRegistry &registry, ModelRegistry::Id model = Best)
+			: registry(registry), model(model) {}
+
+		uint32_t magic() const override { return Magic('R','E','G','0'); }
+		const char *name() const override { return "Registered"; }
+		uint64_t cost(const Histogram &h) const override {
+			const ModelRegistry::Id  id = (model == Best) ? registry.best(h) : model;
+			const uint64_t  c = registry.contains(id) ? registry[id].cost(h) : ~uint64_t(0);
+			return (c == ~uint64_t(0)) ? 4 + CHuffman().cost(h) : 4*((MSB(id + 1) + 2) / 3) + c;
+		}
+		void encode(const Byte *data, Size_t n, Stream &out) override {
+			ModelRegistry::Id  id = model;
+			if (id == Best) id = registry.best(Histogram(data, n));
+			if (!registry.contains(id) || !registry[id].covers(data, n)) {
+				ModelRegistry::write_id(out, 0);
+				CHuffman().encode(data, n, out);
+				return;
+			}
+			ModelRegistry::write_id(out, id + 1);
+			registry[id].encode(data, n, out);
+		}
+		bool decode(Stream &in, Byte *data, Size_t n) override {
+			const ModelRegistry::Id  id = ModelRegistry::read_id(in);
+			if (id == 0) return huffman.decode(in, data, n);
+			if ((id == ModelRegistry::npos) || !registry.contains(id - 1)) return false;
+			return registry[id - 1].decode(in, data, n);
+		}
+	protected:
+		const ModelRegistry	 &registry;
+		ModelRegistry::Id	 model;
+		CHuffman			 huffman;	///< messages à table propre
+	};
+}
+
+#endif
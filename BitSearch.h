@@ -0,0 +1,162 @@
+/// library: bitstream / BitSearch.h (recherche dans un texte codé à taille fixe)
+/// + Bits::CTFSearch : recherche d'un motif dans des données codées par Bits::CTF, sans les décoder.
+///   Le motif est traduit en codes, puis le flux codé est parcouru par fenêtres de 64 bits, chaque
+///   fenêtre comparant en parallèle (SWAR) les 64/w symboles qu'elle contient (w = largeur des codes).
+/// + positions des occurrences en symboles (find, find_all, count).
+
+#ifndef _BITSEARCH
+#define _BITSEARCH
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BitBase.h"
+#include "BitStream.h"
+#include "BitCodec.h"
+
+namespace Bits {
+	/// class Bits::CTFSearch
+	/// Le bloc CTF est lu directement dans le flux: le flux doit rester en vie et ne plus être modifié
+	/// tant que la recherche est utilisée.
+	/// Le symbole d'indice i occupe les bits [base + i*w, base + (i+1)*w[ (code écrit bit de poids faible
+	/// en premier). Une fenêtre lue à partir du bit base + j*w contient donc les symboles j à j+t-1
+	/// (t = 64/w) dans des voies de w bits, quel que soit l'alignement de base + j*w sur les mots du flux.
+	/// Pour chaque voie, la fenêtre est comparée aux Filter premiers symboles du motif (fenêtres j, j+1,
+	/// ...), les voies nulles étant détectées sans retenue entre voies; les candidats restants sont
+	/// vérifiés sur la totalité du motif, par comparaisons de 64 bits.
+	class CTFSearch {
+	public:
+		/// position retournée par find en l'absence d'occurrence
+		static constexpr Size_t npos = ~Size_t(0);
+		/// nombre de symboles du motif utilisés par le filtre
+		enum : Size_t { Filter = 3 };
+
+		CTFSearch() = default;
+		/// @brief bloc produit par CTF::encode pour n symboles, commençant au bit from du flux.
+		/// @detail retourne faux si le bloc est incomplet.
+		bool open_block(const Stream &stream, Size_t n, Size_t from) {
+			data = &stream;
+			count = 0;
+			if (n == 0) return true;
+			if (from + 8 > stream.get_bit_size()) return false;
+			k = stream.read_bits(from, 8) + 1;
+			if (from + 8 + 8*k > stream.get_bit_size()) return false;
+			std::fill(code, code + 256, Size_t(NoCode));
+			for(Size_t i=0;i<k;++i) code[stream.read_bits(from + 8 + 8*i, 8)] = i;
+			w = CTF::width(k);
+			base = from + 8 + 8*k;
+			if (uint64_t(base) + uint64_t(n)*w > stream.get_bit_size()) return false;
+			count = n;
+			if (w) {	// constantes des voies
+				const Size_t  t = 64 / w;
+				ones = 0;
+				for(Size_t i=0;i<t;++i) ones |= uint64_t(1) << (i*w);
+				high = ones << (w - 1);
+				low = high - ones;
+			}
+			return true;
+		}
+		/// @brief flux produit par CTF::compress (magic number, nombre de symboles, bloc), lu à partir du bit from.
+		bool open(const Stream &stream, Size_t from = 0) {
+			if (from + 64 > stream.get_bit_size()) return false;
+			if (stream.read_bits(from, 32) != CTF().magic()) return false;
+			return open_block(stream, stream.read_bits(from + 32, 32), from + 64);
+		}
+
+		/// nombre de symboles du texte et largeur des codes
+		inline Size_t size() const { return count; }
+		inline Size_t width() const { return w; }
+
+		/// @brief position (en symboles) de la première occurrence de pattern à partir de start (npos si aucune).
+		Size_t find(const std::string &pattern, Size_t start = 0) const {
+			Size_t  r = npos;
+			scan(pattern, start, [&r](Size_t p) { r = p; return false; });
+			return r;
+		}
+		/// @brief positions (en symboles) de toutes les occurrences de pattern, éventuellement chevauchantes.
+		std::vector<Size_t> find_all(const std::string &pattern) const {
+			std::vector<Size_t>  r;
+			scan(pattern, 0, [&r](Size_t p) { r.push_back(p); return true; });
+			return r;
+		}
+		/// @brief nombre d'occurrences de pattern
+		Size_t count_all(const std::string &pattern) const {
+			Size_t  r = 0;
+			scan(pattern, 0, [&r](Size_t) { ++r; return true; });
+			return r;
+		}
+
+	protected:
+		enum : Size_t { NoCode = 256 };
+		const Stream  *data = nullptr;
+		Size_t		  count = 0, k = 0, w = 0, base = 0;
+		Size_t		  code[256];			///< code de chaque octet (NoCode s'il est absent du texte)
+		uint64_t	  ones = 0, high = 0, low = 0;	///< bit 0, bit w-1 et bits 0 à w-2 de chaque voie
+
+		/// 64 bits du flux à partir du bit p (les bits au-delà des données sont quelconques ou nuls)
+		inline uint64_t load(Size_t p) const {
+			const Size_t  kw = p / 32, o = p % 32;
+			const Stream::storage_type  *words = data->get_data();
+			if (kw + 2 < data->get_size()) {
+				const uint64_t  v = (uint64_t(words[kw]) | (uint64_t(words[kw + 1]) << 32)) >> o;
+				return o ? v | (uint64_t(words[kw + 2]) << (64 - o)) : v;
+			}
+			// fin du flux: lecture par morceaux de 32 bits au plus
+			uint64_t  v = 0;
+			const Size_t  end = data->get_bit_size();
+			for(Size_t s=0;(s < 64) && (p + s < end);s += 32)
+				v |= uint64_t(data->read_bits(p + s, std::min(Size_t(32), end - p - s))) << s;
+			return v;
+		}
+		/// bit w-1 des voies nulles de z (sans retenue d'une voie à l'autre)
+		inline uint64_t zero_lanes(uint64_t z) const {
+			return ~(((z & low) + low) | z) & high;
+		}
+
+		/// appelle found(p) pour chaque occurrence p >= start, tant que found retourne vrai
+		template <class F> void scan(const std::string &pattern, Size_t start, F found) const {
+			const Size_t  m = Size_t(pattern.size());
+			if ((m == 0) || (m > count) || (start > count - m)) return;
+			// motif traduit en codes, rangés comme dans le flux
+			std::vector<uint64_t>  packed((uint64_t(m)*w + 63) / 64 + 1, 0);
+			for(Size_t i=0;i<m;++i) {
+				const Size_t  c = code[Byte(pattern[i])];
+				if (c == NoCode) return;
+				const Size_t  p = i*w;
+				if (w) {
+					packed[p / 64] |= uint64_t(c) << (p % 64);
+					if (p % 64 + w > 64) packed[p / 64 + 1] |= uint64_t(c) >> (64 - p % 64);
+				}
+			}
+			if (w == 0) {	// un seul symbole dans le texte: toutes les positions conviennent
+				for(Size_t p=start;p<=count-m;++p) if (!found(p)) return;
+				return;
+			}
+			const Size_t  t = 64 / w, nf = std::min(m, Size_t(Filter)), last = count - m;
+			uint64_t  key[Filter];
+			for(Size_t r=0;r<nf;++r) key[r] = ones * code[Byte(pattern[r])];
+			for(Size_t j=start;j<=last;j+=t) {
+				uint64_t  candidates = high;
+				for(Size_t r=0;(r < nf) && candidates;++r) candidates &= zero_lanes(load(base + (j + r)*w) ^ key[r]);
+				while (candidates) {
+					const Size_t  p = j + TrailingZeros(candidates) / w;
+					candidates &= candidates - 1;
+					if (p > last) break;
+					if (((m <= nf) || verify(packed, m, p)) && !found(p)) return;
+				}
+			}
+		}
+		/// comparaison complète du motif codé avec les symboles [p, p+m[
+		inline bool verify(const std::vector<uint64_t> &packed, Size_t m, Size_t p) const {
+			const uint64_t  nbits = uint64_t(m)*w;
+			const Size_t	from = base + p*w;
+			for(Size_t i=0;64*uint64_t(i)<nbits;++i) {
+				const uint64_t  r = nbits - 64*uint64_t(i);
+				const uint64_t  x = load(from + 64*i) ^ packed[i];
+				if ((r >= 64) ? x : (x & ((uint64_t(1) << r) - 1))) return false;
+			}
+			return true;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,149 @@
+/// library: bitstream / BitStats.h (compteurs d'instrumentation)
+/// + compteurs des opérations internes de Bits::Stream (réallocations, octets recopiés, bits
+///   écrits/lus, seek, complétions par des 0 en fin de flux) et chronomètres de codage/décodage.
+/// + actifs seulement si BITSTREAM_STATS est défini à la compilation: sinon BITS_STAT(...) ne
+///   produit aucun code et Stats::snapshot() retourne des compteurs nuls.
+/// + chaque thread incrémente ses propres compteurs; snapshot() fait la somme de tous les threads
+///   (y compris ceux qui sont terminés).
+
+#ifndef _BITSTATS
+#define _BITSTATS
+#include <cstdint>
+#include <iostream>
+#ifdef BITSTREAM_STATS
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#endif
+
+namespace Bits {
+	namespace Stats {
+		/// compteurs disponibles
+		enum Counter : unsigned {
+			Reallocations,		///< appels à Stream::realloc
+			BytesCopied,		///< octets recopiés lors des réallocations
+			BitsWritten,		///< bits écrits dans les flux
+			BitsRead,			///< bits lus dans les flux
+			Seeks,				///< repositionnements des curseurs (seek, seek_end, write_seek)
+			ZeroFills,			///< lectures de Block/varBlock complétées par des 0 (fin de flux)
+			EncodeCalls,		///< appels chronométrés de codage
+			EncodeNanoseconds,	///< temps cumulé de codage
+			DecodeCalls,		///< appels chronométrés de décodage
+			DecodeNanoseconds,	///< temps cumulé de décodage
+			NbCounters
+		};
+		/// nom de chaque compteur (pour affichage)
+		inline const char *name(Counter c) {
+			static const char *names[NbCounters] = {
+				"reallocations", "bytes_copied", "bits_written", "bits_read", "seeks", "zero_fills",
+				"encode_calls", "encode_ns", "decode_calls", "decode_ns" };
+			return names[c];
+		}
+
+		/// valeurs des compteurs à un instant donné
+		struct Snapshot {
+			uint64_t	value[NbCounters] = {};
+			uint64_t operator[](Counter c) const { return value[c]; }
+			/// différence entre deux relevés
+			friend Snapshot operator-(const Snapshot &a, const Snapshot &b) {
+				Snapshot  d;
+				for(unsigned i=0;i<NbCounters;++i) d.value[i] = a.value[i] - b.value[i];
+				return d;
+			}
+			/// affichage sous la forme nom=valeur
+			friend std::ostream& operator<<(std::ostream &os, const Snapshot &s) {
+				for(unsigned i=0;i<NbCounters;++i)
+					os << (i ? " " : "") << name(Counter(i)) << '=' << s.value[i];
+				return os;
+			}
+		};
+
+#ifdef BITSTREAM_STATS
+		/// vrai si l'instrumentation est compilée
+		constexpr bool enabled = true;
+
+		/// compteurs d'un thread. Seul ce thread les modifie; snapshot() les lit depuis un autre
+		/// thread, d'où les atomiques en accès relaxé (pas d'opération atomique lecture-écriture).
+		struct ThreadCounters {
+			std::atomic<uint64_t>	value[NbCounters];
+			ThreadCounters();
+			~ThreadCounters();
+			inline void add(Counter c, uint64_t n) {
+				value[c].store(value[c].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+			}
+		};
+		/// ensemble des compteurs des threads actifs et cumul de ceux des threads terminés
+		struct Registry {
+			std::mutex						lock;
+			std::vector<ThreadCounters*>	threads;
+			Snapshot						retired;
+			static Registry& get() { static Registry r; return r; }
+		};
+		inline ThreadCounters::ThreadCounters() {
+			for(auto &v : value) v.store(0, std::memory_order_relaxed);
+			Registry  &r = Registry::get();
+			std::lock_guard<std::mutex>  guard(r.lock);
+			r.threads.push_back(this);
+		}
+		inline ThreadCounters::~ThreadCounters() {
+			Registry  &r = Registry::get();
+			std::lock_guard<std::mutex>  guard(r.lock);
+			for(unsigned i=0;i<NbCounters;++i) r.retired.value[i] += value[i].load(std::memory_order_relaxed);
+			r.threads.erase(std::remove(r.threads.begin(), r.threads.end(), this), r.threads.end());
+		}
+		/// compteurs du thread courant
+		inline ThreadCounters& local() {
+			thread_local ThreadCounters  counters;
+			return counters;
+		}
+		/// ajoute n au compteur c du thread courant
+		inline void add(Counter c, uint64_t n = 1) { local().add(c, n); }
+		/// somme des compteurs de tous les threads
+		inline Snapshot snapshot() {
+			Registry  &r = Registry::get();
+			std::lock_guard<std::mutex>  guard(r.lock);
+			Snapshot  s = r.retired;
+			for(ThreadCounters *t : r.threads)
+				for(unsigned i=0;i<NbCounters;++i) s.value[i] += t->value[i].load(std::memory_order_relaxed);
+			return s;
+		}
+		/// remet à zéro tous les compteurs (à appeler lorsque les autres threads sont au repos)
+		inline void reset() {
+			Registry  &r = Registry::get();
+			std::lock_guard<std::mutex>  guard(r.lock);
+			r.retired = Snapshot();
+			for(ThreadCounters *t : r.threads)
+				for(auto &v : t->value) v.store(0, std::memory_order_relaxed);
+		}
+		/// chronomètre: ajoute 1 au compteur calls et la durée de vie de l'objet (ns) au compteur time
+		class ScopedTimer {
+		public:
+			ScopedTimer(Counter calls, Counter time)
+				: calls(calls), time(time), start(std::chrono::steady_clock::now()) {}
+			~ScopedTimer() {
+				add(calls);
+				add(time, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start).count()));
+			}
+		protected:
+			Counter		calls, time;
+			std::chrono::steady_clock::time_point	start;
+		};
+#define BITS_STAT(counter, n) ::Bits::Stats::add(::Bits::Stats::counter, (n))
+#else
+		constexpr bool enabled = false;
+		inline Snapshot snapshot() { return Snapshot(); }
+		inline void reset() {}
+		class ScopedTimer {
+		public:
+			ScopedTimer(Counter, Counter) {}
+		};
+// expression vide plutôt que rien: BITS_STAT(...); reste une instruction après un if sans accolades
+#define BITS_STAT(counter, n) ((void)0)
+#endif
+	}
+}
+
+#endif
@@ -8,15 +8,27 @@
 /// + ajout de tests unitaires pour validation
 /// 1.2-6 : Stream copy/assignation fix
 /// 1.2-7 : Stream::Position refactoring & cleaning
+/// 1.2-8 : lecture/écriture par mots (read_bits/write_bits), append et copy_bits
+/// 1.2-9 : points de reprise en écriture (mark/rollback/commit)
+/// 1.2-10: lecture par mots au curseur (peek_bits/get_bits/skip_bits), copie d'octets alignée
+/// 1.2-11: compteurs d'instrumentation (cf BitStats.h, actifs si BITSTREAM_STATS est défini)
+/// 1.2-12: lectures avec politique de vérification (read<Checked>/read<Unchecked>), lecture des
+///         Block/varBlock par mots
+/// 1.2-13: affichage binaire/hexadécimal rapide par tables (cf BitDump.h), Dump(...) et dump(...)
+/// 1.2-14: instantanés immuables partagés (freeze/Frozen) et copie sur écriture, écriture des
+///         Block/varBlock par mots (write_msb)
 
 
 #ifndef _BITSTREAM
 #define _BITSTREAM
 #include <cstring>
+#include <memory>
 #include "BitBase.h"
 #include "BitBlock.h"
+#include "BitStats.h"
+#include "BitDump.h"
 
-#ifdef _DEBUG
+#if defined(_DEBUG) && !defined(BITSTREAM_UNCHECKED)
 #include <stdio.h>
 #define DEBUG(x) x
 #ifndef __PRETTY_FUNCTION__
@@ -37,20 +49,8 @@ namespace Bits {
 		BinaryArray(Size_t _size, const T* _array, const Size_t _pack, const Size_t _offset, const Size_t _maxbit)
 			: array(_array), size(_size), pack(_pack),  offset(_offset), maxbit(_maxbit) {}
 		friend std::ostream& operator<<(std::ostream &stream, const BinaryArray &v) {
-				Size_t        ibit = 0, rbit = 0; // rbit = numéro relatif du bit
-				const Size_t  nbit = 8*sizeof(T);
-				for(Size_t k=0;k<v.size;++k) { // sur tous les éléments du tableau
-					T   mask = 1;
-					for(Size_t i=0;i<nbit;++i,++ibit,mask<<=1) {
-						if (ibit >= v.offset) {
-								stream << (v.array[k] & mask ? '1' : '0');
-								rbit = ibit - v.offset + 1;
-								if (rbit == v.maxbit) break;
-								if (rbit % v.pack == 0) stream << ' ';
-						}
-					}
-					if (rbit == v.maxbit) break;
-				}
+				Dumper  dumper(DumpFormat(DumpFormat::Bin, v.pack));
+				dumper.write(stream, v.array, v.size, v.offset, size_t(v.offset) + v.maxbit);
 				return stream;
 		}
 	};
@@ -117,6 +117,40 @@ namespace Bits {
             friend bool operator>>(Stream &stream, Bit &b);
             friend bool operator==(const Stream& stream1, const Stream& stream2);
         };
+        /// point de reprise du curseur d'écriture (cf mark/rollback/commit)
+        class Checkpoint {
+        protected:
+            Position      position;       ///< position d'écriture au moment du mark()
+            storage_type  word = 0;       ///< contenu du bloc partiellement écrit à cette position
+            bool          active = false; ///< faux après commit()
+        public:
+            /// vrai si le point de reprise peut encore être utilisé par rollback()
+            inline bool is_active() const { return active; }
+            /// position d'écriture mémorisée
+            inline const Position& getPosition() const { return position; }
+            friend class Stream;
+        };
+        /// instantané immuable des données d'un flux (cf freeze). La copie est en O(1) (compteur de
+        /// références) et un instantané peut être partagé entre threads. Stream(frozen) donne un flux
+        /// qui lit ces données sans les recopier.
+        class Frozen {
+        public:
+            Frozen() = default;
+            /// taille des données (bits, octets, unités de stockage)
+            inline Size_t get_bit_size() const { return nbits; }
+            inline Size_t get_byte_size() const { return (nbits + 7) / 8; }
+            inline Size_t get_size() const { return (nbits + storage_unit_size - 1) / storage_unit_size; }
+            /// données (en lecture seule)
+            inline const storage_type *get_data() const { return data.get(); }
+            inline const char *get_buffer() const { return reinterpret_cast<const char*>(data.get()); }
+            /// nombre de flux et d'instantanés qui partagent ces données
+            inline long use_count() const { return data.use_count(); }
+        protected:
+            std::shared_ptr<storage_type>  data;
+            Size_t						   nbits = 0;
+            Frozen(std::shared_ptr<storage_type> data, Size_t nbits) : data(std::move(data)), nbits(nbits) {}
+            friend class Stream;
+        };
 	protected:
 		/// taille de la zone de données réservée
 		Size_t			storage_size;
@@ -124,14 +158,45 @@ namespace Bits {
         Position        WritePosition,ReadPosition;
         /// pointeur vers la zone de données
         storage_type	*buff;
+        /// données partagées avec des instantanés (cf freeze), nul si buff appartient au flux.
+        /// Un flux partagé a une zone réservée nulle (storage_size = 0): toute écriture passe donc
+        /// par realloc, qui recopie les données (copie sur écriture) sans test supplémentaire.
+        std::shared_ptr<storage_type>  shared;
         /// méthode interne de réallocation
 		inline void realloc(Size_t new_size) {
+            // flux partagé: la nouvelle zone contient au moins les données écrites et le bloc d'écriture
+            if (shared) new_size = std::max(new_size, WritePosition.LastBlock() + 1);
             storage_type	*tmp = new storage_type[new_size];
-            if (buff != nullptr) memcpy(tmp, buff, storage_size*sizeof(storage_type));
-            delete[] buff;
+            const Size_t	used = shared ? WritePosition.LastBlock() : storage_size;
+            BITS_STAT(Reallocations, 1);
+            if (buff != nullptr) BITS_STAT(BytesCopied, used*sizeof(storage_type));
+            if (buff != nullptr) memcpy(tmp, buff, used*sizeof(storage_type));
+            if (shared) shared.reset();
+            else delete[] buff;
             buff = tmp;
             storage_size = new_size;
 		}
+		/// garantit que la zone de stockage peut contenir nBits bits à partir du début du flux.
+		/// Le bloc contenant le bit nBits doit aussi exister (invariant: WritePosition.iBlock < storage_size).
+		inline void reserve_bits(Size_t nBits) {
+			Size_t  needed = nBits / storage_unit_size + 1;
+			if (needed <= storage_size) return;
+			// croissance géométrique: coût amorti constant de l'agrandissement (au lieu de recopier le
+			// flux toutes les alloc_unit_size unités)
+			needed = std::max(needed, storage_size + storage_size / 2);
+			Size_t  nb_units = (needed + alloc_unit_size - 1) / alloc_unit_size;
+			realloc(nb_units * alloc_unit_size);
+		}
+		/// écrit les nbits bits de poids faible de value à la position d'écriture, sans vérifier la place mémoire.
+		/// Les bits du bloc courant situés après la position d'écriture sont remis à zéro.
+		inline void put_bits(storage_type value, Size_t nbits) {
+			Size_t    k = WritePosition.iBlock, o = WritePosition.iBit;
+			uint64_t  v = uint64_t(value & mask<storage_type>(0, nbits)) << o;
+			buff[k] = storage_type((buff[k] & mask<storage_type>(0, o)) | v);
+			if (o + nbits > storage_unit_size) buff[k+1] = storage_type(v >> storage_unit_size);
+			WritePosition.seek(WritePosition.LastBit() + nbits);
+			BITS_STAT(BitsWritten, nbits);
+		}
 	public:
 		///@name gestion de la place mémoire pour le stream
 		///@{
@@ -159,29 +224,49 @@ namespace Bits {
             WritePosition(), ReadPosition(),
             buff( new storage_type[storage_size] ) {}
 
-		/// constructeur par copie
+		/// constructeur par copie (en O(1) si s partage les données d'un instantané)
 		inline Stream(const Stream& s):
             storage_size(s.storage_size),
             WritePosition(s.WritePosition), ReadPosition(s.ReadPosition),
-			buff( s.storage_size ? new storage_type[s.storage_size] : nullptr ) {
+			buff( s.shared ? s.buff : (s.storage_size ? new storage_type[s.storage_size] : nullptr) ),
+			shared(s.shared) {
 			Size_t  memsize = WritePosition.LastByte();
-			if (memsize) memcpy((void*)buff,(void*)s.buff,memsize);
+			if (memsize && !shared) memcpy((void*)buff,(void*)s.buff,memsize);
 		}
+		/// flux lisant les données de l'instantané f, sans recopie (jusqu'à la première modification)
+		inline explicit Stream(const Frozen& f):
+			storage_size(f.data ? 0 : Size_t(alloc_unit_size)),
+			WritePosition(f.data ? f.nbits : 0), ReadPosition(),
+			buff( f.data ? f.data.get() : new storage_type[alloc_unit_size] ),
+			shared(f.data) {}
 		/// constructeur par déplacement
 		inline Stream(Stream&& s):
 			storage_size(s.storage_size),
             WritePosition(s.WritePosition), ReadPosition(s.ReadPosition),
-            buff(s.buff)
+            buff(s.buff), shared(std::move(s.shared))
 		{
 			s.buff = nullptr;
 			s.storage_size = 0;
 			s.WritePosition.reset();
 			s.ReadPosition.reset();
 		}
-		/// assignation par copie
+		/// assignation par copie (en O(1) si origin partage les données d'un instantané)
 		inline Stream& operator=(const Stream& origin) {
 			if (this != &origin) {
+				if (origin.shared) {
+					if (!shared) delete[] buff;
+					buff = origin.buff;
+					shared = origin.shared;
+					storage_size = 0;
+					WritePosition = origin.WritePosition;
+					ReadPosition = origin.ReadPosition;
+					return *this;
+				}
 				Size_t   origin_size = origin.WritePosition.LastBlock();
+				if (shared) {
+					WritePosition.reset();
+					realloc(origin_size + 1);
+				}
 				if (storage_size < origin_size) request_storage_size(origin_size);
 				if (origin_size) memcpy((void*)buff,(void*)origin.buff,origin_size*sizeof(storage_type));
 				WritePosition = origin.WritePosition;
@@ -193,6 +278,7 @@ namespace Bits {
 		inline Stream& operator=(Stream&& origin) {
 			if (this != &origin) {
 				std::swap(buff,origin.buff);
+				std::swap(shared,origin.shared);
 				std::swap(storage_size,origin.storage_size);
 				std::swap(WritePosition,origin.WritePosition);
 				std::swap(ReadPosition,origin.ReadPosition);
@@ -201,7 +287,7 @@ namespace Bits {
 		}
         /// destructeur
         inline ~Stream() {
-            delete[] buff;
+            if (!shared) delete[] buff;
             buff = nullptr;
         }
 
@@ -219,6 +305,7 @@ namespace Bits {
 		/// Utile pour recycler un flux.
 		inline void clear() {
 			reset();
+			if (shared) realloc(alloc_unit_size);
 			memset(buff, 0, storage_size*sizeof(storage_type));
 		}
 
@@ -230,6 +317,7 @@ namespace Bits {
 			ReadPosition.reset();
 		}
 		/// retour du pointeur sur le buffer de données
+		/// (en lecture seule si le flux partage ses données avec un instantané: cf own())
 		inline storage_type	*get_data() const { return buff; }
 		/// retourne un pointeur char* vers les données du stream.
 		inline char *get_buffer() const { return (char*)(buff); }
@@ -247,9 +335,11 @@ namespace Bits {
 		/// le flux.
         /// réinitialise la position de lecture.
 		inline bool write_seek(const Size_t ibit) {
+			own();
 			if ( ibit >= get_storage_bit_size() ) return false;
 			WritePosition.seek(ibit);
             ReadPosition.reset();
+            BITS_STAT(Seeks, 1);
             return true;
 		}
 		///@}
@@ -264,6 +354,7 @@ namespace Bits {
 			Size_t    maxbits = WritePosition.LastBit();
 			if (ibit >= maxbits) return false;
 			ReadPosition.seek(ibit);
+			BITS_STAT(Seeks, 1);
             return true;
 		}
  		///@brief déplacement du pointeur de lecture en bit depuis le fin du flux
@@ -285,89 +376,260 @@ namespace Bits {
 
 	  ///@}
 
+		///@name instantanés immuables (copie sur écriture)
+		/// Usage: f = stream.freeze() sur un flux terminé; f se copie en O(1) et se partage entre threads;
+		/// chaque lecteur crée son flux Stream(f) (sans recopie des données), avec ses propres curseurs.
+		///@{
+		/// @brief instantané des données écrites. Les données ne sont pas recopiées: le flux les partage
+		/// ensuite avec l'instantané et reste lisible; sa première modification les recopie.
+		inline Frozen freeze() {
+			if (!shared) {
+				shared.reset(buff, std::default_delete<storage_type[]>());
+				storage_size = 0;
+			}
+			return Frozen(shared, WritePosition.LastBit());
+		}
+		/// vrai si le flux partage ses données avec un instantané
+		inline bool is_shared() const { return bool(shared); }
+		/// @brief recopie les données partagées pour que le flux en soit seul propriétaire (sans effet
+		/// sinon). A appeler avant d'écrire directement dans get_data().
+		inline void own() {
+			if (shared) realloc(WritePosition.LastBlock() + alloc_unit_size);
+		}
+		///@}
+
+		///@name points de reprise pour l'écriture spéculative
+		/// Usage: c = mark(); essai d'un codage; si le résultat ne convient pas, rollback(c) puis
+		/// essai d'un autre codage; commit(c) lorsque le codage est retenu.
+		///@{
+		/// @brief mémorise la position d'écriture et l'état du bloc partiellement écrit.
+		inline Checkpoint mark() const {
+			Checkpoint  c;
+			c.position = WritePosition;
+			c.word = (buff != nullptr) ? buff[WritePosition.iBlock] : 0;
+			c.active = true;
+			return c;
+		}
+		/// @brief annule tout ce qui a été écrit depuis mark(c): le curseur d'écriture et le bloc
+		/// partiellement écrit retrouvent exactement leur état. Le curseur de lecture est ramené
+		/// au curseur d'écriture s'il était au-delà. c reste utilisable pour un autre essai.
+		/// Retourne faux si c n'est plus actif ou si le flux a été ramené avant c entre temps.
+		inline bool rollback(const Checkpoint& c) {
+			if (!c.active || (c.position.LastBit() > WritePosition.LastBit())) return false;
+			own();
+			WritePosition = c.position;
+			buff[WritePosition.iBlock] = c.word;
+			if (ReadPosition.LastBit() > WritePosition.LastBit()) ReadPosition = WritePosition;
+			return true;
+		}
+		/// @brief valide les écritures faites depuis mark(c). c n'est plus utilisable ensuite.
+		inline void commit(Checkpoint& c) const { c.active = false; }
+		/// @brief nombre de bits écrits depuis mark(c).
+		inline Size_t bits_since(const Checkpoint& c) const {
+			return WritePosition.LastBit() - c.position.LastBit();
+		}
+		///@}
+
+		///@name accès par mots (au plus storage_unit_size bits à la fois)
+		/// Les bits sont rangés dans l'ordre du flux: le bit 0 de la valeur est le premier bit du flux.
+		///@{
+		/// @brief retourne les nbits bits du flux commençant au bit ibit (ibit = 0 est le premier bit).
+		/// @detail nbits doit être compris entre 1 et storage_unit_size, et [ibit,ibit+nbits[ doit être
+		/// dans les données écrites. Ne modifie pas le pointeur de lecture.
+		inline storage_type read_bits(Size_t ibit, Size_t nbits) const {
+			BITS_ASSERT( (nbits <= storage_unit_size) && "nbits plus grand que le type de stockage");
+			BITS_ASSERT( (ibit + nbits <= WritePosition.LastBit()) && "lecture au-delà des données écrites");
+			Size_t    k = ibit / storage_unit_size, o = ibit % storage_unit_size;
+			uint64_t  w = buff[k];
+			if (o + nbits > storage_unit_size) w |= uint64_t(buff[k+1]) << storage_unit_size;
+			return storage_type((w >> o) & mask<uint64_t>(0, nbits));
+		}
+		/// @brief écrit les nbits bits de poids faible de value à la position d'écriture.
+		/// @detail nbits doit être compris entre 0 et storage_unit_size.
+		inline Stream& write_bits(storage_type value, Size_t nbits) {
+			BITS_ASSERT( (nbits <= storage_unit_size) && "nbits plus grand que le type de stockage");
+			reserve_bits(WritePosition.LastBit() + nbits);
+			put_bits(value, nbits);
+			return *this;
+		}
+		/// @brief retourne les nbits bits suivants à partir du curseur de lecture, sans le déplacer.
+		/// @detail Les bits au-delà des données écrites sont lus comme des 0.
+		inline storage_type peek_bits(Size_t nbits) const {
+			Size_t  ibit = ReadPosition.LastBit(), avail = WritePosition.LastBit() - ibit;
+			if (nbits <= avail) return read_bits(ibit, nbits);
+			return avail ? read_bits(ibit, avail) : 0;
+		}
+		/// @brief avance le curseur de lecture de nbits bits (sans dépasser le curseur d'écriture).
+		inline void skip_bits(Size_t nbits) {
+			// par soustraction: ReadPosition.LastBit() + nbits peut dépasser la capacité de Size_t
+			const Size_t  from = ReadPosition.LastBit(), end = WritePosition.LastBit();
+			const Size_t  ibit = (from >= end) ? end : from + std::min(nbits, end - from);
+			BITS_STAT(BitsRead, ibit - from);
+			ReadPosition.seek(ibit);
+		}
+		/// @brief lit les nbits bits suivants à partir du curseur de lecture et avance celui-ci.
+		/// @detail Les bits au-delà des données écrites sont lus comme des 0.
+		inline storage_type get_bits(Size_t nbits) {
+			storage_type  v = peek_bits(nbits);
+			skip_bits(nbits);
+			return v;
+		}
+		/// @brief complète le bloc courant par des 0 pour aligner le curseur d'écriture sur un bloc.
+		inline Stream& align_write() {
+			if (WritePosition.iBit) write_bits(0, storage_unit_size - WritePosition.iBit);
+			return *this;
+		}
+		/// @brief aligne le curseur de lecture sur le début du bloc suivant.
+		inline void align_read() {
+			if (ReadPosition.iBit) skip_bits(storage_unit_size - ReadPosition.iBit);
+		}
+		/// @brief écrit n octets bruts après alignement du curseur d'écriture (copie par memcpy).
+		/// @detail Les octets sont rangés dans l'ordre de la mémoire, comme pour get_buffer().
+		inline Stream& write_bytes(const void *data, Size_t n) {
+			align_write();
+			reserve_bits(WritePosition.LastBit() + 8*n);
+			if (n) memcpy((void*)(buff + WritePosition.iBlock), data, n);
+			WritePosition.seek(WritePosition.LastBit() + 8*n);
+			BITS_STAT(BitsWritten, 8*n);
+			return *this;
+		}
+		/// @brief lit au plus n octets bruts après alignement du curseur de lecture (copie par memcpy).
+		/// Retourne le nombre d'octets lus.
+		inline Size_t read_bytes(void *data, Size_t n) {
+			align_read();
+			n = std::min(n, (WritePosition.LastBit() - ReadPosition.LastBit()) / 8);
+			if (n) memcpy(data, (void*)(buff + ReadPosition.iBlock), n);
+			ReadPosition.seek(ReadPosition.LastBit() + 8*n);
+			BITS_STAT(BitsRead, 8*n);
+			return n;
+		}
+		/// @brief ajoute à la position d'écriture les n bits de src commençant au bit src_bit.
+		/// @detail La copie se fait par mots entiers (décalage sur 64 bits entre deux mots successifs),
+		/// et par memcpy si les deux positions sont alignées sur un mot. src peut être le flux lui-même.
+		/// Retourne faux (sans rien écrire) si [src_bit,src_bit+n[ n'est pas dans les données écrites de src.
+		inline bool copy_bits(const Stream& src, Size_t src_bit, Size_t n) {
+			if ((n > src.get_bit_size()) || (src_bit > src.get_bit_size() - n)) return false;
+			if (n == 0) return true;
+			reserve_bits(WritePosition.LastBit() + n);
+			if ((WritePosition.iBit == 0) && (src_bit % storage_unit_size == 0)) {
+				Size_t  nwords = n / storage_unit_size;
+				memmove(buff + WritePosition.iBlock, src.buff + src_bit / storage_unit_size,
+						nwords * sizeof(storage_type));
+				WritePosition.seek(WritePosition.LastBit() + nwords * storage_unit_size);
+				BITS_STAT(BitsWritten, nwords * storage_unit_size);
+				src_bit += nwords * storage_unit_size;
+				n -= nwords * storage_unit_size;
+			}
+			for(; n >= storage_unit_size; n -= storage_unit_size, src_bit += storage_unit_size)
+				put_bits(src.read_bits(src_bit, storage_unit_size), storage_unit_size);
+			if (n) put_bits(src.read_bits(src_bit, n), n);
+			return true;
+		}
+		/// @brief ajoute toutes les données écrites de src à la position d'écriture (concaténation).
+		inline Stream& append(const Stream& src) {
+			copy_bits(src, 0, src.WritePosition.LastBit());
+			return *this;
+		}
+		///@}
+
+		///@name lectures avec politique de vérification (cf Bits::Checked et Bits::Unchecked)
+		/// Les opérateurs >> utilisent Checked. Unchecked supprime tous les tests de fin de flux:
+		/// à réserver aux boucles dont le nombre de bits à lire a déjà été validé.
+		///@{
+		/// @brief lecture d'un bit. Avec Checked, retourne faux (sans rien lire) en fin de flux.
+		template <class Policy = Checked> inline bool read(Bit &b) {
+			if (Policy::check && (ReadPosition == WritePosition)) return false;
+			b = Bits::get<storage_type>(buff[ReadPosition.iBlock], ReadPosition.iBit);
+			ReadPosition.next();
+			BITS_STAT(BitsRead, 1);
+			return true;
+		}
+		/// @brief lecture de nbits bits (1 à 64) rangés MSB en premier, comme les écrit operator<< pour les Block.
+		/// @detail count reçoit le nombre de bits effectivement lus. Avec Checked, si la fin du flux est
+		/// atteinte, les bits lus sont les bits de poids fort et les bits manquants sont des 0.
+		template <class Policy = Checked> inline uint64_t read_msb(Size_t nbits, Size_t &count) {
+			Size_t  avail = WritePosition.LastBit() - ReadPosition.LastBit();
+			count = nbits;
+			if (Policy::check && (avail < nbits)) {
+				BITS_STAT(ZeroFills, 1);
+				count = avail;
+				if (avail == 0) return 0;
+			}
+			Size_t    ibit = ReadPosition.LastBit(), low = std::min<Size_t>(count, storage_unit_size);
+			uint64_t  v = read_bits(ibit, low);
+			if (count > low) v |= uint64_t(read_bits(ibit + low, count - low)) << storage_unit_size;
+			ReadPosition.seek(ibit + count);
+			BITS_STAT(BitsRead, count);
+			return Reverse<uint64_t>(v, count) << (nbits - count);
+		}
+		/// @brief écriture des nbits bits (0 à 64) de poids faible de value, MSB en premier (comme les Block).
+		/// @detail écriture par mots (write_bits): le test de partage de données (cf freeze) n'est fait
+		/// que dans reserve_bits, lorsque la zone doit être agrandie.
+		inline Stream& write_msb(uint64_t value, Size_t nbits) {
+			if (nbits == 0) return *this;
+			const uint64_t  v = Reverse<uint64_t>(value, nbits);
+			const Size_t	low = std::min<Size_t>(nbits, storage_unit_size);
+			write_bits(storage_type(v), low);
+			if (nbits > low) write_bits(storage_type(v >> storage_unit_size), nbits - low);
+			return *this;
+		}
+		/// @brief lecture d'un Block. Retourne le nombre de bits lus (cf read_msb pour la fin de flux).
+		template <class Policy = Checked, int NBITS> inline Size_t read(Block<NBITS> &bitblock) {
+			Size_t  count;
+			bitblock.set( typename Block<NBITS>::Type(read_msb<Policy>(Size_t(NBITS), count)) );
+			return count;
+		}
+		/// @brief lecture d'un varBlock sur son nombre de bits valides. Retourne le nombre de bits lus.
+		template <class Policy = Checked> inline Size_t read(varBlock &bitblock) {
+			Size_t  count = 0;
+			if (bitblock.get_valid()) bitblock.set( read_msb<Policy>(bitblock.get_valid(), count) );
+			return count;
+		}
+		///@}
+
 		///@name surcharge des opérateurs pour lecture/écriture dans le stream
 		/// attention: les opérateurs >> renvoient toujours le nombre de bits lus.
 		///@{
 		/// surcharge opérateur de stream pour les bits.
-		/// écriture d'un bit
+		/// écriture d'un bit (les données partagées avec un instantané sont d'abord recopiées)
 		friend Stream& operator<<(Stream &stream, const Bit &bit) {
 			Stream::Position&  pos = stream.WritePosition;
+			stream.own();
 			stream.buff[pos.iBlock]
 					= Bits::set<storage_type>(stream.buff[pos.iBlock], pos.iBit, 1, bit);
 			if (pos.next() == stream.storage_size)
 				stream.realloc(stream.storage_size + stream.alloc_unit_size);
+			BITS_STAT(BitsWritten, 1);
 			return stream;
 		}
 		/// surcharge opérateur de stream pour les bits.
 		/// lecture d'un bit
 		friend bool operator>>(Stream &stream, Bit &b) {
-			if (stream.ReadPosition == stream.WritePosition) return false;
-			Stream::Position&  pos = stream.ReadPosition;
-			b = Bits::get<storage_type>(stream.buff[pos.iBlock], pos.iBit);
-			pos.next();
-			return true;
+			return stream.read<Checked>(b);
 		}
 
 		/// surcharge opérateur de stream pour les Bits:Block.
 		/// écriture d'un BitsBlock
 		template <int NBITS> friend
 			Stream&	operator<<(Stream &stream, const Block<NBITS> &bitblock) {
-				Size_t	 valid = bitblock.get_valid() - 1;
-				for(Size_t i = 0;i <= valid;++i) {
-					Bit  bit = get<typename Block<NBITS>::Type>(bitblock.get(), valid-i);
-					stream << bit;
-				}
-				return stream;
+				return stream.write_msb(uint64_t(bitblock.get()), bitblock.get_valid());
 		};
 		/// surcharge opérateur de stream pour les Bits:Block.
 		/// lecture d'un BitsBlock
 		template <int NBITS> friend
 			Size_t operator>>(Stream &stream, Block<NBITS> &bitblock) {
-				Size_t	count = 0, valid = bitblock.get_valid() - 1;
-				for(Size_t i = 0; i <= valid; ++i) {
-					Bit  bit;
-					bool read_bit = stream >> bit;
-					if (read_bit)	{
-						bitblock.set( Bits::set<typename Block<NBITS>::Type>(bitblock.get(), valid-i, 1, bit) );
-						++count;
-					} else  {
-						// complète le reste de la lecture avec des 0
-						for(Size_t j=i;j<=valid;++j)
-							bitblock.set( Bits::set<typename Block<NBITS>::Type>(bitblock.get(), valid-j, 1, 0));
-						break; // plus de bits à lire (fin de flux)
-					}
-				}
-				return count;
+				return stream.read<Checked>(bitblock);
 		}
 
 		/// surcharge opérateur de stream pour les Bits:Block.
 		/// écriture d'un BitsBlock
 		friend Stream&	operator<<(Stream &stream, const varBlock &bitblock) {
-			Size_t	 valid = bitblock.get_valid() - 1;
-			for(Size_t i=0;i<=valid;++i) {
-				Bit  bit = get<typename varBlock::Type>(bitblock.get(), valid-i);
-				stream << bit;
-			}
-			return stream;
+			return stream.write_msb(uint64_t(bitblock.get()), bitblock.get_valid());
 		};
 		/// surcharge opérateur de stream pour les Bits:Block.
 		/// lecture d'un BitsBlock
 		friend	Size_t operator>>(Stream &stream, varBlock &bitblock) {
-				Size_t	count = 0, valid = bitblock.get_valid() - 1;
-				for(Size_t  i = 0; i <= valid; ++i) {
-					Bit  bit;
-					bool read_bit = stream >> bit;
-					if (read_bit)	{
-						bitblock.set( Bits::set<varBlock::Type>(bitblock.get(), valid-i, 1, bit) );
-						++count;
-					} else  {
-						// complète le reste de la lecture avec des 0
-						for(Size_t j=i;j<=valid;++j)
-							bitblock.set( Bits::set<varBlock::Type>(bitblock.get(), valid-j, 1, 0));
-						break; // plus de bits à lire (fin de flux)
-					}
-				}
-				return count;
+				return stream.read<Checked>(bitblock);
 		}
 
         /// surcharge de l'opérateur == pour comparer deux flux;
@@ -432,6 +694,32 @@ namespace Bits {
 					pack,offset,(maxbit?maxbit:stream.get_bit_size()-offset));
 			}
 
+		/// @brief affichage rapide des bits [from, to[ du flux (to borné à la taille du flux).
+		/// @param dumper porte le format et le tampon, réutilisable d'un affichage à l'autre.
+		void dump(std::ostream &os, Dumper &dumper, Size_t from = 0, Size_t to = ~Size_t(0)) const {
+			dumper.write(os, buff, WritePosition.LastBlock(), from, std::min(to, get_bit_size()));
+		}
+		void dump(std::ostream &os, const DumpFormat &format = DumpFormat(), Size_t from = 0, Size_t to = ~Size_t(0)) const {
+			Dumper  dumper(format);
+			dump(os, dumper, from, to);
+		}
+
+		/// @brief classe technique intermédiaire pour os << Dump(stream, ...)
+		struct DumpObject {
+			const Stream	&stream;
+			DumpFormat		format;
+			Size_t			from, to;
+			friend std::ostream& operator<<(std::ostream &os, const DumpObject &d) {
+				d.stream.dump(os, d.format, d.from, d.to);
+				return os;
+			}
+		};
+		/// @brief fonction à utiliser pour affichage en binaire/hexadécimal d'un intervalle du flux.
+		/// ex: std::cout << Dump(s, DumpFormat(DumpFormat::Hex, 32, 256, true), 0, 4096);
+		friend DumpObject Dump(const Stream &stream, const DumpFormat &format = DumpFormat(), Size_t from = 0, Size_t to = ~Size_t(0)) {
+			return DumpObject{stream, format, from, to};
+		}
+
 		///=================================================================================================
 		/// surcharge pour affichage direct d'un stream dans un flux de sortie
 		/// @param os		le flux de sortie
@@ -440,7 +728,7 @@ namespace Bits {
 			return os << BinaryArray<Stream::storage_type>(
 				stream.WritePosition.LastBlock(),
 				stream.buff,
-				stream.get_bit_size(), 0, stream.get_bit_size());
+				0, 0, stream.get_bit_size());
 		}
 
 	};
@@ -0,0 +1,316 @@
+/// library: bitstream / mesure des codeurs sur un corpus de fichiers
+/// + codeurs de BitCodec.h, BitParallel.h, BitBWT.h et BitContext.h.
+/// + pour chaque codeur et chaque fichier: taux de compression, débits de codage/décodage (Mo/s),
+///   pic de mémoire allouée et nombre d'allocations, pic de RSS pendant le cas au-dessus du RSS de
+///   départ (remise à zéro du pic par /proc/self/clear_refs, -1 si impossible).
+/// + chaque ligne est étiquetée par le nom du codeur suivi de ses paramètres de construction.
+/// + compteurs matériels (cycles, instructions, défauts de cache) via perf_event_open si --perf
+///   est demandé et si le noyau l'autorise.
+/// + sortie CSV sur la sortie standard.
+/// usage: BitStream-corpus [répertoire (défaut corpus)] [--generate texte] [--perf] [--quick]
+///   --generate crée le répertoire avec une copie du texte donné et des fichiers générés.
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+#include <sstream>
+#include <atomic>
+#include <filesystem>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "BitCodec.h"
+#include "BitParallel.h"
+#include "BitBWT.h"
+#include "BitContext.h"
+using namespace std;
+namespace fs = std::filesystem;
+
+/// comptage des allocations: chaque bloc est précédé de sa taille
+namespace {
+	atomic<uint64_t>	alloc_count{0}, alloc_current{0}, alloc_peak{0};
+	constexpr size_t	Header = alignof(max_align_t);
+
+	void *counted_alloc(size_t n) {
+		char  *p = static_cast<char*>(malloc(n + Header));
+		if (!p) throw bad_alloc();
+		*reinterpret_cast<size_t*>(p) = n;
+		++alloc_count;
+		uint64_t  cur = alloc_current += n, peak = alloc_peak;
+		while ((cur > peak) && !alloc_peak.compare_exchange_weak(peak, cur)) {}
+		return p + Header;
+	}
+	void counted_free(void *q) noexcept {
+		if (!q) return;
+		char  *p = static_cast<char*>(q) - Header;
+		alloc_current -= *reinterpret_cast<size_t*>(p);
+		free(p);
+	}
+}
+void *operator new(size_t n) { return counted_alloc(n); }
+void *operator new[](size_t n) { return counted_alloc(n); }
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+
+namespace {
+	double	MinTime = 0.2;
+
+	/// compteurs matériels d'un groupe perf_event (désactivés si l'ouverture échoue)
+	class HardwareCounters {
+	public:
+		static constexpr int NbCounters = 3;
+		explicit HardwareCounters(bool enable) {
+#ifdef __linux__
+			if (!enable) return;
+			const uint64_t  config[NbCounters] = {
+				PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+			for(int i=0;i<NbCounters;++i) {
+				perf_event_attr  attr{};
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.size = sizeof(attr);
+				attr.config = config[i];
+				attr.disabled = (i == 0);
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_GROUP;
+				fd[i] = int(syscall(__NR_perf_event_open, &attr, 0, -1, i ? fd[0] : -1, 0));
+				if (fd[i] < 0) { close_all(); return; }
+			}
+#else
+			(void)enable;
+#endif
+		}
+		~HardwareCounters() { close_all(); }
+		bool active() const { return fd[0] >= 0; }
+		void start() {
+#ifdef __linux__
+			if (!active()) return;
+			ioctl(fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+		}
+		/// arrête le comptage et retourne les valeurs (cycles, instructions, défauts de cache)
+		vector<uint64_t> stop() {
+			vector<uint64_t>  values;
+#ifdef __linux__
+			if (!active()) return values;
+			ioctl(fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+			uint64_t  buffer[1 + NbCounters];
+			if (read(fd[0], buffer, sizeof(buffer)) == ssize_t(sizeof(buffer)))
+				values.assign(buffer + 1, buffer + 1 + buffer[0]);
+#endif
+			return values;
+		}
+	protected:
+		int		fd[NbCounters] = { -1, -1, -1 };
+		void close_all() {
+#ifdef __linux__
+			for(int &f : fd) if (f >= 0) { close(f); f = -1; }
+#endif
+		}
+	};
+
+	/// mesure d'une opération: meilleur temps (s), allocations et pic de mémoire du premier passage
+	struct Measure {
+		double				seconds = 0.0;
+		uint64_t			allocations = 0, peak_bytes = 0;
+		vector<uint64_t>	counters;
+	};
+	template <class F> Measure measure(HardwareCounters &hw, F fn) {
+		using clock = chrono::steady_clock;
+		Measure  m;
+		uint64_t  count0 = alloc_count;
+		alloc_peak = alloc_current.load();
+		uint64_t  base = alloc_current;
+		hw.start();
+		clock::time_point  start = clock::now();
+		fn();
+		m.seconds = chrono::duration<double>(clock::now() - start).count();
+		m.counters = hw.stop();
+		m.allocations = alloc_count - count0;
+		m.peak_bytes = alloc_peak - base;
+		// répétitions pour les fichiers courts
+		double  total = m.seconds;
+		while (total < MinTime) {
+			start = clock::now();
+			fn();
+			double  t = chrono::duration<double>(clock::now() - start).count();
+			m.seconds = min(m.seconds, t);
+			total += t;
+		}
+		return m;
+	}
+
+	Bits::Bytes read_file(const fs::path &path) {
+		ifstream  file(path, std::ios::in | std::ios::binary);
+		return Bits::Bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	}
+	void write_file(const fs::path &path, const Bits::Bytes &data) {
+		ofstream  file(path, std::ios::out | std::ios::binary);
+		file.write(reinterpret_cast<const char*>(data.data()), streamsize(data.size()));
+	}
+
+	/// crée le corpus: texte de référence, texte généré à partir de ses mots, binaire aléatoire,
+	/// binaire à distribution géométrique, et mélange des trois.
+	void generate(const fs::path &dir, const fs::path &text_file) {
+		fs::create_directories(dir);
+		Bits::Bytes  text = read_file(text_file);
+		write_file(dir / text_file.filename(), text);
+
+		mt19937  gen(2018);
+		const size_t  Size = 1u << 20;
+		// texte: mots de la référence tirés au hasard
+		vector<string>  words;
+		string  word;
+		for(Bits::Byte c : text) {
+			if (isalpha(c)) word += char(c);
+			else if (!word.empty()) { words.push_back(word); word.clear(); }
+		}
+		if (words.empty()) words.push_back("bitstream");
+		Bits::Bytes  generated;
+		while (generated.size() < Size) {
+			const string  &w = words[gen() % words.size()];
+			generated.insert(generated.end(), w.begin(), w.end());
+			generated.push_back(gen() % 12 ? ' ' : '\n');
+		}
+		write_file(dir / "generated.txt", generated);
+
+		Bits::Bytes  random(Size);
+		for(auto &b : random) b = Bits::Byte(gen());
+		write_file(dir / "random.bin", random);
+
+		Bits::Bytes  skewed(Size);
+		geometric_distribution<int>  geo(0.2);
+		for(auto &b : skewed) b = Bits::Byte(min(geo(gen), 255));
+		write_file(dir / "skewed.bin", skewed);
+
+		Bits::Bytes  mixed;
+		for(size_t k=0;k<Size;k+=1u<<16) {
+			const Bits::Bytes  &src = (k >> 16) % 3 == 0 ? generated : ((k >> 16) % 3 == 1 ? random : skewed);
+			mixed.insert(mixed.end(), src.begin() + long(k), src.begin() + long(k + (1u << 16)));
+		}
+		write_file(dir / "mixed.bin", mixed);
+	}
+
+	/// champ de /proc/self/status en ko (VmRSS: RSS courant, VmHWM: pic de RSS), -1 si indisponible
+	long status_kb(const string &key) {
+		ifstream  status("/proc/self/status");
+		string	  line;
+		while (getline(status, line))
+			if (line.compare(0, key.size(), key) == 0) return stol(line.substr(key.size()));
+		return -1;
+	}
+	/// @brief remet le pic de RSS (VmHWM) au RSS courant. Retourne faux si le noyau ne le permet pas.
+	bool reset_peak_rss() {
+		ofstream  clear("/proc/self/clear_refs");
+		return bool(clear << "5" << flush);
+	}
+
+	/// codeur et étiquette de ses lignes: nom du codeur suivi des paramètres de construction
+	struct Entry {
+		unique_ptr<Bits::Codec>	codec;
+		string					label;
+	};
+	template <class C, class... Args> void add(vector<Entry> &codecs, Args... args) {
+		unique_ptr<Bits::Codec>  codec(new C(args...));
+		ostringstream  label;
+		label << boolalpha << codec->name();
+		if (sizeof...(args)) {
+			// ';' et non ',' pour rester dans une colonne du CSV
+			size_t  i = 0;
+			((label << (i++ ? ';' : '(') << args), ...);
+			label << ')';
+		}
+		codecs.push_back({ move(codec), label.str() });
+	}
+}
+
+int main(int argc, char *argv[]) {
+	fs::path	dir = "corpus", text_file;
+	bool		perf = false;
+	for(int i=1;i<argc;++i) {
+		string  arg = argv[i];
+		if (arg == "--perf") perf = true;
+		else if (arg == "--quick") MinTime = 0.0;
+		else if ((arg == "--generate") && (i + 1 < argc)) text_file = argv[++i];
+		else dir = arg;
+	}
+	if (!text_file.empty()) generate(dir, text_file);
+	if (!fs::is_directory(dir)) {
+		cerr << "répertoire " << dir << " introuvable (utiliser --generate USconstitution.txt)" << endl;
+		return 1;
+	}
+	vector<fs::path>  files;
+	for(const auto &entry : fs::directory_iterator(dir))
+		if (entry.is_regular_file()) files.push_back(entry.path());
+	sort(files.begin(), files.end());
+
+	vector<Entry>  codecs;
+	add<Bits::CStored>(codecs);
+	add<Bits::CTF>(codecs);
+	add<Bits::CHuffman>(codecs);
+	add<Bits::CParallelHuffman>(codecs);
+	add<Bits::CLZ>(codecs);
+	add<Bits::CBWT>(codecs);
+	add<Bits::CContext>(codecs, Bits::Size_t(1), false);
+	add<Bits::CContext>(codecs, Bits::Size_t(2), true);
+	add<Bits::CAdaptive>(codecs);
+	add<Bits::CAdaptive>(codecs, Bits::Size_t(1u << 16), true, true);
+
+	HardwareCounters  hw(perf);
+	if (perf && !hw.active()) cerr << "perf_event_open indisponible: compteurs matériels ignorés" << endl;
+	cout << "codec,file,bytes,compressed,ratio,encode_MBps,decode_MBps,"
+		"encode_allocs,encode_peak_bytes,decode_allocs,decode_peak_bytes,rss_peak_delta_kB,verified";
+	if (hw.active()) cout << ",encode_cycles,encode_instructions,encode_cache_misses"
+		",decode_cycles,decode_instructions,decode_cache_misses";
+	cout << endl;
+
+	for(const fs::path &file : files) {
+		Bits::Bytes  data = read_file(file);
+		for(const Entry &entry : codecs) {
+			Bits::Codec		&codec = *entry.codec;
+			const bool		rss = reset_peak_rss();
+			const long		rss_start = status_kb("VmRSS:");
+			Bits::Stream	encoded;
+			Measure  enc = measure(hw, [&] {
+				encoded.reset();
+				codec.compress(data, encoded);
+			});
+			Bits::Bytes  decoded;
+			bool		 ok = true;
+			Measure  dec = measure(hw, [&] {
+				encoded.seek(0);
+				ok = codec.decompress(encoded, decoded) && ok;
+			});
+			ok = ok && (decoded == data);
+			const long  rss_delta = rss ? status_kb("VmHWM:") - rss_start : -1;
+			double  mb = double(data.size()) / 1e6;
+			cout << entry.label << ',' << file.filename().string() << ',' << data.size() << ','
+				<< encoded.get_byte_size() << ','
+				<< (encoded.get_byte_size() ? double(data.size()) / encoded.get_byte_size() : 0.0) << ','
+				<< mb / enc.seconds << ',' << mb / dec.seconds << ','
+				<< enc.allocations << ',' << enc.peak_bytes << ','
+				<< dec.allocations << ',' << dec.peak_bytes << ','
+				<< rss_delta << ',' << (ok ? "yes" : "no");
+			if (hw.active()) {
+				for(size_t i=0;i<size_t(HardwareCounters::NbCounters);++i) cout << ',' << (i < enc.counters.size() ? enc.counters[i] : 0);
+				for(size_t i=0;i<size_t(HardwareCounters::NbCounters);++i) cout << ',' << (i < dec.counters.size() ? dec.counters[i] : 0);
+			}
+			cout << endl;
+		}
+	}
+	return 0;
+}
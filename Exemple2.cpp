@@ -6,6 +6,7 @@
 /// + Bits::varBlock : Block avec un nombre de bits valides variable
 /// + ajout d'une fonction Binary pour visualiser les données en binaires dans un flux.
 /// + ajout de tests unitaires pour validation
+/// + lecture paresseuse des Block<5> par Bits::blocks<5> (BitDecode.h)
 
 #include <iostream>
 #include <fstream>
@@ -14,6 +15,7 @@
 
 // vous devez lire l'implémentation de bitstream avant de l'utiliser
 #include "BitStream.h"
+#include "BitDecode.h"
 using namespace std;
 
 int main() {
@@ -66,6 +68,13 @@ int main() {
 	for(auto x : vOut) cout << x << " ";
 	cout << endl;
 
+	// lecture paresseuse (cf BitDecode.h): les valeurs sont décodées au fur et à mesure du parcours,
+	// sans passer par un vecteur intermédiaire
+	stream1.seek(0);
+	int  sum = 0;
+	for(auto x : Bits::blocks<5>(stream1)) sum += x;
+	cout << "Somme des valeurs relues à la volée: " << sum << endl;
+
 	// écriture des valeurs du stream dans un fichiers
 	const char *OutputFile = "data.bin";
 	ofstream  file1(OutputFile, std::ios::out | std::ios::binary );
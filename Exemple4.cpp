@@ -0,0 +1,52 @@
+/// library: bitstream / exemple 4 (compression d'un fichier avec les codeurs de BitCodec.h)
+/// + Bits::Codec : classe mère des codeurs (compress/decompress avec entête commune)
+/// + Bits::CAdaptive : choix du codeur bloc par bloc
+/// + Bits::CParallelHuffman (BitParallel.h) : décodage réparti sur plusieurs threads
+/// + vérification de la position du curseur de lecture après décompression (fin des données)
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include "BitCodec.h"
+#include "BitParallel.h"
+using namespace std;
+
+int main(int argc, char *argv[]) {
+	const char  *InputFile = (argc > 1 ? argv[1] : "USconstitution.txt");
+	ifstream  input(InputFile, std::ios::in | std::ios::binary);
+	if (!input) { cout << "impossible d'ouvrir " << InputFile << endl; return 1; }
+	Bits::Bytes  data((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+	cout << InputFile << ": " << data.size() << " octets" << endl;
+
+	Bits::CStored	 stored;
+	Bits::CTF		 ctf;
+	Bits::CHuffman	 huffman;
+	Bits::CLZ		 lz;
+	Bits::CAdaptive  adaptive(4096, true, true);  // blocs de 4 Ko, essai de LZ77, CRC en pied
+	Bits::CParallelHuffman  gaps(4), sync(4, 0);   // 4 threads, avec ou sans table des écarts
+	Bits::Codec		 *codecs[] = { &stored, &ctf, &huffman, &lz, &adaptive, &gaps, &sync };
+
+	for(Bits::Codec *codec : codecs) {
+		// compression puis sauvegarde dans un fichier
+		Bits::Stream  stream;
+		codec->compress(data, stream);
+		const char *OutputFile = "data.bin";
+		Bits::save(OutputFile, stream);
+
+		// rechargement puis décompression
+		Bits::Stream  reloaded;
+		Bits::Bytes   result;
+		Bits::load(OutputFile, reloaded);
+		bool ok = codec->decompress(reloaded, result) && (result == data);
+		// le curseur de lecture doit être juste après les données décodées (ici, la fin du flux)
+		ok = ok && (reloaded.getReadPosition().LastBit() == stream.get_bit_size());
+		cout << codec->name() << ": " << stream.get_byte_size() << " octets"
+			<< (ok ? " (vérifié)" : " (ERREUR)") << endl;
+	}
+	const auto &usage = adaptive.get_usage();
+	cout << "blocs du codage adaptatif: stockés=" << usage[Bits::CAdaptive::Stored]
+		<< " taille fixe=" << usage[Bits::CAdaptive::FixedWidth]
+		<< " Huffman=" << usage[Bits::CAdaptive::Entropy]
+		<< " LZ77=" << usage[Bits::CAdaptive::Dictionary] << endl;
+	return 0;
+}
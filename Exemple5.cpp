@@ -0,0 +1,660 @@
+/// library: bitstream / exemple 5 (vérification des structures de données et des codeurs)
+/// + chaque structure est comparée à un calcul naïf (parcours bit à bit, std::search, std::lower_bound)
+///   ou relue après écriture, aux tailles qui tombent sur les frontières de mots et de blocs.
+/// + relectures de données tronquées ou fabriquées: read() et decompress doivent échouer proprement,
+///   sans lecture hors des données ni allocation démesurée.
+/// + code de retour non nul si une vérification échoue (utilisé par ctest et par make check).
+/// usage: Exemple5 [fichier texte (défaut USconstitution.txt)]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "BitCodec.h"
+#include "BitRank.h"
+#include "BitOps.h"
+#include "BitPacked.h"
+#include "BitColumn.h"
+#include "BitEliasFano.h"
+#include "BitSearch.h"
+#include "BitRegistry.h"
+#include "BitBatch.h"
+#include "BitRecord.h"
+#include "BitDecode.h"
+#include "BitFile.h"
+#include "BitParallel.h"
+#include "BitBWT.h"
+#include "BitContext.h"
+using namespace std;
+using Bits::Size_t;
+
+namespace {
+	int		 failures = 0;
+	mt19937  gen(2018);
+
+	/// compte et affiche les vérifications qui échouent
+	void check(bool ok, const string &what) {
+		if (ok) return;
+		if (++failures <= 50) cout << "ERREUR: " << what << endl;
+	}
+	/// flux de n bits aléatoires, chaque bit valant 1 avec la probabilité density
+	Bits::Stream random_bits(Size_t n, double density) {
+		bernoulli_distribution  coin(density);
+		Bits::Stream  s;
+		for(Size_t i=0;i<n;++i) s.write_bits(coin(gen), 1);
+		return s;
+	}
+	inline bool bit(const Bits::Stream &s, Size_t i) { return s.read_bits(i, 1) != 0; }
+	/// les nbits premiers bits de s (curseur de lecture au début)
+	Bits::Stream prefix(const Bits::Stream &s, Size_t nbits) {
+		Bits::Stream  t;
+		t.copy_bits(s, 0, nbits);
+		return t;
+	}
+	/// longueurs de troncature: toutes les premières, puis environ 100 réparties jusqu'à n
+	vector<Size_t> cuts(Size_t n, Size_t first = 160) {
+		vector<Size_t>  r;
+		for(Size_t t=0;(t<n) && (t<first);++t) r.push_back(t);
+		for(Size_t t=first;t<n;t+=std::max(Size_t(1), n / 100)) r.push_back(t);
+		if (n) r.push_back(n - 1);
+		return r;
+	}
+	string str(uint64_t x) { return to_string(x); }
+
+	/// rank/select comparés aux comptes naïfs, aux frontières de mots (64), blocs (512) et super-blocs (2^16)
+	void check_rank() {
+		const Size_t  sizes[] = { 0, 1, 63, 64, 65, 511, 512, 513, 65535, 65536, 65537, 140000 };
+		const double  densities[] = { 0.0, 0.001, 0.5, 0.999, 1.0 };
+		for(Size_t n : sizes) for(double d : densities) {
+			const Bits::Stream  s = random_bits(n, d);
+			const Bits::RankSelect  rs(s);
+			const string  what = "RankSelect n=" + str(n) + " densité=" + to_string(d);
+			Size_t  ones = 0;
+			vector<Size_t>  pos1, pos0;
+			bool  ok = true;
+			for(Size_t i=0;i<=n;++i) {
+				ok = ok && (rs.rank1(i) == ones) && (rs.rank0(i) == i - ones);
+				if (i == n) break;
+				ok = ok && (rs.access(i) == bit(s, i));
+				if (bit(s, i)) { ++ones; pos1.push_back(i); } else pos0.push_back(i);
+			}
+			check(ok, what + ": rank/access");
+			check((rs.ones() == ones) && (rs.zeros() == n - ones), what + ": nombre de 1");
+			ok = true;
+			for(Size_t k=0;k<pos1.size();++k) ok = ok && (rs.select1(k) == pos1[k]);
+			for(Size_t k=0;k<pos0.size();++k) ok = ok && (rs.select0(k) == pos0[k]);
+			check(ok, what + ": select");
+		}
+		// longues plages de 1 et de 0 (échantillons de select éloignés de plusieurs super-blocs)
+		Bits::Stream  runs;
+		for(Size_t r=0;r<6;++r) for(Size_t i=0;i<70000 + 3*r;++i) runs.write_bits(r & 1, 1);
+		const Bits::RankSelect  rs(runs);
+		bool  ok = true;
+		for(Size_t k=0, i=0;i<runs.get_bit_size();++i)
+			if (bit(runs, i)) ok = ok && (rs.select1(k++) == i);
+		for(Size_t k=0, i=0;i<runs.get_bit_size();++i)
+			if (!bit(runs, i)) ok = ok && (rs.select0(k++) == i);
+		check(ok, "RankSelect: plages");
+	}
+
+	/// Elias-Fano: accès, parcours, next_geq/skip_to comparés à std::lower_bound, relecture
+	void check_elias_fano() {
+		const uint64_t  gaps[] = { 0, 1, 2, 1000, uint64_t(1) << 40 };
+		const Size_t	counts[] = { 0, 1, 2, 100, 5000 };
+		for(uint64_t gap : gaps) for(Size_t n : counts) {
+			const string  what = "EliasFano n=" + str(n) + " écart=" + str(gap);
+			uniform_int_distribution<uint64_t>  step(0, gap);
+			vector<uint64_t>  v;
+			uint64_t  x = step(gen);
+			for(Size_t i=0;i<n;++i) v.push_back(x += step(gen));
+			const Bits::EliasFano  ef(v);
+			bool  ok = (ef.size() == n);
+			for(Size_t i=0;ok && (i<n);++i) ok = (ef[i] == v[i]);
+			Size_t  i = 0;
+			for(auto it=ef.begin();it!=ef.end();++it, ++i) ok = ok && (it.index() == i) && (*it == v[i]);
+			check(ok && (i == n), what + ": accès et parcours");
+
+			vector<uint64_t>  probes = { 0, n ? v.back() + 1 : 1 };
+			for(uint64_t y : v) { probes.push_back(y); probes.push_back(y + 1); if (y) probes.push_back(y - 1); }
+			sort(probes.begin(), probes.end());
+			ok = true;
+			auto  cursor = ef.begin();
+			for(uint64_t p : probes) {
+				const Size_t  expected = Size_t(lower_bound(v.begin(), v.end(), p) - v.begin());
+				const auto	  it = ef.next_geq(p);
+				ok = ok && (it.index() == expected) && ((expected == n) || (*it == v[expected]));
+				if (cursor != ef.end()) cursor.skip_to(p);
+				ok = ok && (cursor.index() == expected);
+			}
+			check(ok, what + ": next_geq et skip_to");
+
+			Bits::Stream  s;
+			s << ef;
+			Bits::EliasFano  r;
+			check(r.read(s) && (r.size() == n) && equal(v.begin(), v.end(), r.begin()) && s.end_of_stream(), what + ": relecture");
+			ok = true;
+			for(Size_t t : cuts(s.get_bit_size())) {
+				Bits::Stream  cut = prefix(s, t);
+				ok = ok && !r.read(cut);
+			}
+			check(ok && (r.size() == n), what + ": relecture tronquée");
+		}
+		// entêtes fabriqués: nombre de valeurs et taille de highs incohérents avec les données
+		Bits::Stream  s;
+		s.write_bits(0xFFFFFFFFu, 32);
+		s.write_bits(63, 7);
+		s.write_bits(0xFFFFFFC0u, 32);
+		for(Size_t i=0;i<8;++i) s.write_bits(0xFFFFFFFFu, 32);
+		Bits::EliasFano  r;
+		check(!r.read(s), "EliasFano: entête fabriqué");
+		Bits::Stream  ones;
+		ones << Bits::EliasFano(vector<uint64_t>{ 1, 2, 3 });
+		Bits::Stream  bad = prefix(ones, 71);
+		for(Size_t i=0;i<64;++i) bad.write_bits(1, 1);	// 64 valeurs dans highs au lieu de 3
+		check(!r.read(bad), "EliasFano: highs incohérent");
+	}
+
+	/// and/or/xor/andnot et popcount comparés au calcul bit à bit, y compris avec des bits parasites
+	/// après la fin des données dans le dernier mot des opérandes
+	template <class O, class F> void check_op(const char *name, F naive) {
+		const Size_t  sizes[] = { 0, 1, 31, 32, 33, 64, 100, 255, 256, 257, 1000, 1031 };
+		bool  ok = true;
+		for(Size_t na : sizes) for(Size_t nb : sizes) {
+			Bits::Stream  a = random_bits(na + 40, 0.5), b = random_bits(nb + 40, 0.5);
+			a.write_seek(na);
+			b.write_seek(nb);
+			const Size_t  n = std::max(na, nb);
+			const Bits::Stream  r = Bits::combine<O>(a, b);
+			Bits::Stream  c(a);
+			Bits::combine_assign<O>(c, b);
+			uint64_t  count = 0;
+			ok = ok && (r.get_bit_size() == n) && (c.get_bit_size() == n);
+			for(Size_t i=0;ok && (i<n);++i) {
+				const bool  x = naive((i < na) && bit(a, i), (i < nb) && bit(b, i));
+				count += x;
+				ok = (bit(r, i) == x) && (bit(c, i) == x);
+			}
+			ok = ok && (Bits::popcount<O>(a, b) == count) && (Bits::popcount(r) == count);
+		}
+		check(ok, string("combine ") + name);
+	}
+	void check_ops() {
+		check_op<Bits::Op::And>("and", [](bool x, bool y) { return x && y; });
+		check_op<Bits::Op::Or>("or", [](bool x, bool y) { return x || y; });
+		check_op<Bits::Op::Xor>("xor", [](bool x, bool y) { return x != y; });
+		check_op<Bits::Op::AndNot>("andnot", [](bool x, bool y) { return x && !y; });
+	}
+
+	/// tableau compacté comparé à std::vector et à l'écriture des Block<N> correspondants
+	template <class Vec, class Ref, class Make> void check_packed(const string &what, Vec v, Ref block, Make make) {
+		const Size_t  w = v.width(), n = 1000;
+		const uint64_t  mask = (w == 64) ? ~uint64_t(0) : (uint64_t(1) << w) - 1;
+		vector<uint64_t>  ref;
+		for(Size_t i=0;i<n;++i) {
+			ref.push_back((uint64_t(gen()) << 32 | gen()) & mask);
+			v.push_back(typename Vec::value_type(ref.back()));
+		}
+		bool  ok = (v.size() == n);
+		for(Size_t i=0;ok && (i<n);i+=7) {
+			ref[i] = ~ref[i] & mask;
+			v.set(i, typename Vec::value_type(ref[i]));
+		}
+		for(Size_t i=0;ok && (i<n);++i) ok = (v[i] == ref[i]);
+		check(ok && equal(v.begin(), v.end(), ref.begin()), what + ": get/set");
+
+		Bits::Stream  s, expected;
+		s << v;
+		for(uint64_t x : ref) block(expected, x);
+		check(s == expected, what + ": écriture comme des Block");
+		Vec  r(v);
+		r.clear();
+		check(r.read(s, n) == n && (r == v), what + ": relecture");
+		Bits::Stream  shifted;
+		shifted.write_bits(0x55, 7);
+		shifted << v;
+		const Vec  from = make(shifted, n, 7);
+		check(from == v, what + ": construction depuis un flux (décalage de 7 bits)");
+		Bits::Stream  cut = prefix(expected, n*w - 1);
+		check(r.read(cut, n) == n - 1, what + ": relecture tronquée");
+		v.resize(10);
+		v.resize(20);
+		ok = true;
+		for(Size_t i=10;i<20;++i) ok = ok && (v[i] == 0);
+		check(ok, what + ": resize");
+	}
+	void check_packed_vectors() {
+		check_packed("PackedVector<5>", Bits::PackedVector<5>(),
+			[](Bits::Stream &s, uint64_t x) { s << Bits::Block<5>(Bits::Block<5>::Type(x)); },
+			[](const Bits::Stream &s, size_t n, Size_t from) { return Bits::PackedVector<5>(s, n, from); });
+		check_packed("PackedVector<33>", Bits::PackedVector<33>(),
+			[](Bits::Stream &s, uint64_t x) { s << Bits::Block<33>(x); },
+			[](const Bits::Stream &s, size_t n, Size_t from) { return Bits::PackedVector<33>(s, n, from); });
+		check_packed("PackedVector<64>", Bits::PackedVector<64>(),
+			[](Bits::Stream &s, uint64_t x) { s << Bits::Block<64>(x); },
+			[](const Bits::Stream &s, size_t n, Size_t from) { return Bits::PackedVector<64>(s, n, from); });
+		check_packed("varPackedVector(13)", Bits::varPackedVector(13),
+			[](Bits::Stream &s, uint64_t x) { s << Bits::varBlock(13, x); },
+			[](const Bits::Stream &s, size_t n, Size_t from) { return Bits::varPackedVector(13, s, n, from); });
+	}
+
+	/// affichage d'un flux comparé à sa lecture bit à bit
+	void check_dump() {
+		for(Size_t n : { 0u, 1u, 31u, 32u, 33u, 1003u }) {
+			const Bits::Stream  s = random_bits(n, 0.5);
+			string  expected;
+			for(Size_t i=0;i<n;++i) expected += bit(s, i) ? '1' : '0';
+			ostringstream  os;
+			os << s;
+			check(os.str() == expected, "operator<<(ostream) " + str(n) + " bits");
+		}
+	}
+
+	/// colonnes d'entiers: aller-retour aux tailles de bloc (128), dans les deux modes, relectures tronquées
+	template <class T> void check_column(const string &what, const vector<T> &values) {
+		Bits::CColumn  column;
+		Bits::Stream  s;
+		column.compress(values, s);
+		vector<T>  out;
+		check(column.decompress(s, out) && (out == values) && s.end_of_stream(), what + ": aller-retour");
+		bool  ok = true;
+		for(Size_t t : cuts(s.get_bit_size(), 80)) {
+			Bits::Stream  cut = prefix(s, t);
+			ok = ok && !column.decompress(cut, out);
+		}
+		check(ok, what + ": données tronquées");
+		// entête annonçant 0xFFFFFFF0 valeurs, suivie des blocs d'origine
+		Bits::Stream  big;
+		big.write_bits(Bits::CColumn::magic(), 32);
+		big.write_bits(0xFFFFFFF0u, 32);
+		big.copy_bits(s, 64, s.get_bit_size() - 64);
+		check(!column.decompress(big, out), what + ": taille fabriquée acceptée");
+	}
+	void check_column() {
+		for(Size_t n : { 0u, 1u, 127u, 128u, 129u, 1000u }) {
+			vector<uint64_t>  times;
+			vector<int32_t>   noise;
+			uint64_t  t = 1500000000000ull;
+			for(Size_t i=0;i<n;++i) {
+				times.push_back(t += 1000 + gen() % 16);
+				noise.push_back(int32_t(gen() % 2001) - 1000);
+			}
+			check_column("CColumn horodatages " + str(n), times);
+			check_column("CColumn signés " + str(n), noise);
+		}
+		check_column("CColumn extrêmes", vector<int64_t>{ INT64_MIN, INT64_MAX, 0, -1, INT64_MAX, INT64_MIN });
+	}
+
+	/// recherche dans un texte codé par CTF comparée à std::search (occurrences qui se chevauchent comprises)
+	void check_search_text(const string &what, const Bits::Bytes &text, const vector<string> &patterns) {
+		Bits::Stream  s;
+		Bits::CTF().compress(text, s);
+		Bits::CTFSearch  search;
+		check(search.open(s) && (search.size() == text.size()), what + ": ouverture");
+		bool  ok = true;
+		for(const string &p : patterns) {
+			vector<Size_t>  expected;
+			for(auto it=text.begin();;++it) {
+				it = std::search(it, text.end(), p.begin(), p.end(), [](Bits::Byte x, char y) { return x == Bits::Byte(y); });
+				if (it == text.end()) break;
+				expected.push_back(Size_t(it - text.begin()));
+			}
+			ok = ok && (search.find_all(p) == expected) && (search.count_all(p) == expected.size());
+			ok = ok && (search.find(p) == (expected.empty() ? Bits::CTFSearch::npos : expected[0]));
+			if (expected.size() > 1) ok = ok && (search.find(p, expected[0] + 1) == expected[1]);
+		}
+		check(ok, what + ": occurrences");
+		ok = true;
+		for(Size_t t : cuts(s.get_bit_size())) {
+			Bits::Stream  cut = prefix(s, t);
+			ok = ok && !search.open(cut);
+		}
+		check(ok, what + ": flux tronqué");
+	}
+	void check_search(const Bits::Bytes &text) {
+		const Bits::Bytes  sample(text.begin(), text.begin() + long(std::min(text.size(), size_t(20000))));
+		vector<string>  patterns = { "zzqzzq", string(1, '\x01'), "the", "e", "  " };
+		for(Size_t i=0;i<200;++i) {
+			const size_t  len = 1 + gen() % 12, at = gen() % (sample.size() - len);
+			patterns.push_back(string(sample.begin() + long(at), sample.begin() + long(at + len)));
+		}
+		check_search_text("CTFSearch texte", sample, patterns);
+		check_search_text("CTFSearch un symbole", Bits::Bytes(3000, 'a'), { "a", "aaa", "ab", "b" });
+		Bits::Bytes  binary(3000), all(256);
+		for(auto &b : binary) b = Bits::Byte(gen() % 2 ? 'x' : 'y');
+		for(Size_t i=0;i<256;++i) all[i] = Bits::Byte(i);
+		binary.insert(binary.end(), all.begin(), all.end());
+		check_search_text("CTFSearch 256 symboles", binary, { "xyx", "yyyyyyy", string("\xfe\xff", 2), "x", string(1, '\0') });
+	}
+
+	/// registre de modèles: codage/décodage de messages avec un registre relu, relectures tronquées
+	void check_registry(const Bits::Bytes &text) {
+		Bits::ModelRegistry  registry;
+		registry.train(text.data(), Size_t(std::min(text.size(), size_t(4096))));
+		const Bits::Bytes  digits = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+		registry.add(Bits::Histogram(digits.data(), Size_t(digits.size())), Bits::Model::FixedWidth);
+		check(registry.size() == 2, "ModelRegistry: ajout");
+
+		Bits::Stream  table;
+		table << registry;
+		Bits::ModelRegistry  reloaded;
+		check(reloaded.read(table) && (reloaded.size() == 2) && (reloaded[0].fingerprint() == registry[0].fingerprint()), "ModelRegistry: relecture");
+		bool  ok = true;
+		for(Size_t t : cuts(table.get_bit_size())) {
+			Bits::Stream  cut = prefix(table, t);
+			Bits::ModelRegistry  r;
+			ok = ok && !r.read(cut);
+		}
+		check(ok, "ModelRegistry: relecture tronquée");
+
+		Bits::CRegistered  encoder(registry), decoder(reloaded);
+		vector<Bits::Bytes>  messages = { {}, { '4', '2' }, { 0, 1, 2, 255 } };
+		for(Size_t i=0;i<50;++i) {
+			const size_t  len = 1 + gen() % 200, at = gen() % (text.size() - len);
+			messages.push_back(Bits::Bytes(text.begin() + long(at), text.begin() + long(at + len)));
+		}
+		Bits::Stream  s;
+		for(const auto &m : messages) encoder.encode(m.data(), Size_t(m.size()), s);
+		ok = true;
+		for(const auto &m : messages) {
+			Bits::Bytes  out(m.size());
+			ok = ok && decoder.decode(s, out.data(), Size_t(out.size())) && (out == m);
+		}
+		check(ok && s.end_of_stream(), "CRegistered: messages");
+		Bits::Stream  id;
+		for(Size_t i=0;i<12;++i) id.write_bits(1, 4);
+		check(Bits::ModelRegistry::read_id(id) == Bits::ModelRegistry::npos, "ModelRegistry: numéro trop long");
+		Bits::Stream  unknown;
+		Bits::ModelRegistry::write_id(unknown, 7);
+		Bits::Bytes  out(10);
+		check(!decoder.decode(unknown, out.data(), 10), "CRegistered: modèle inconnu");
+	}
+
+	/// lot d'enregistrements: accès direct, parcours, décodage par un codeur, relectures tronquées
+	void check_batch(const Bits::Bytes &text) {
+		Bits::BatchWriter	 writer;
+		vector<vector<Size_t>>  records;
+		for(Size_t i=0;i<300;++i) {
+			// enregistrements vides au début, au milieu et à la fin
+			const Size_t  len = (i < 3) || (i % 50 == 0) || (i >= 297) ? 0 : Size_t(gen() % 20);
+			vector<Size_t>  r;
+			for(Size_t k=0;k<len;++k) r.push_back(Size_t(gen() % 2048));
+			writer.add([&r](Bits::Stream &s) { for(Size_t x : r) s << Bits::Block<11>(Bits::Block<11>::Type(x)); });
+			records.push_back(r);
+		}
+		Bits::CHuffman  huffman;
+		const Bits::Bytes  message(text.begin(), text.begin() + 500);
+		const Size_t  coded = writer.add(huffman, message.data(), Size_t(message.size()));
+		Bits::Stream  s;
+		s << writer;
+		s.write_bits(0x2A, 6);	// données qui suivent le lot
+
+		Bits::BatchReader  reader;
+		check(reader.read(s) && (reader.size() == writer.size()) && (reader.bit_size() == writer.bit_size()), "BatchReader: relecture");
+		check(s.get_bit_size() - s.getReadPosition().LastBit() == 6, "BatchReader: curseur après le lot");
+		bool  ok = true;
+		for(Size_t i=0;i<records.size();++i) {
+			Bits::Stream  &in = reader.open(i);
+			ok = ok && (reader.end(i) - reader.begin(i) == 11*records[i].size());
+			for(Size_t x : records[i]) {
+				Bits::Block<11>  b;
+				in >> b;
+				ok = ok && (b.get() == x);
+			}
+		}
+		check(ok, "BatchReader: accès direct");
+		ok = reader.for_each([&](Size_t i, Bits::Stream &in, Size_t end) {
+			if (i < records.size()) return in.getReadPosition().LastBit() + 11*records[i].size() == end;
+			return i == coded;
+		});
+		check(ok, "BatchReader: parcours");
+		Bits::Bytes  out(message.size());
+		check(reader.decode(coded, huffman, out.data(), Size_t(out.size())) && (out == message), "BatchReader: décodage");
+
+		ok = true;
+		for(Size_t t : cuts(s.get_bit_size() - 6)) {
+			Bits::Stream  cut = prefix(s, t);
+			Bits::BatchReader  r;
+			ok = ok && !r.read(cut);
+		}
+		check(ok, "BatchReader: relecture tronquée");
+		// annuaire fabriqué: un enregistrement finissant au bit 0xFFFFFFF0, sans les données
+		Bits::Stream  crafted;
+		crafted << Bits::EliasFano(vector<uint64_t>{ 0xFFFFFFF0u });
+		crafted.write_bits(0xFFFFFFF0u, 32);
+		crafted.write_bits(0x2A, 6);
+		Bits::BatchReader  r;
+		check(!r.read(crafted), "BatchReader: taille fabriquée acceptée");
+	}
+
+	/// enregistrements à schéma fixe: écriture comme des Block, relecture en lignes et en colonnes
+	void check_record() {
+		using R = Bits::Record<Bits::Field<3>, Bits::Field<17>, Bits::Field<64>, Bits::Field<1>, Bits::Field<40>>;
+		vector<R>  v;
+		Bits::Stream  expected;
+		for(Size_t i=0;i<1000;++i) {
+			const uint64_t  c = uint64_t(gen()) << 32 | gen(), e = (uint64_t(gen()) << 8 ^ gen()) & ((uint64_t(1) << 40) - 1);
+			v.push_back(R(Bits::Byte(gen() & 7), uint32_t(gen() & 0x1FFFF), c, (gen() & 1) != 0, e));
+			expected << Bits::Block<3>(v.back().get<0>()) << Bits::Block<17>(v.back().get<1>()) << Bits::Block<64>(c)
+					 << Bits::Block<1>(v.back().get<3>()) << Bits::Block<40>(e);
+		}
+		Bits::Stream  s;
+		R::write(s, v);
+		check(s == expected, "Record: écriture comme des Block");
+		vector<R>  rows;
+		R::Columns  columns;
+		bool  ok = R::read(s, v.size(), rows) && (s.getReadPosition().LastBit() == v.size()*R::bits);
+		s.seek(0);
+		ok = ok && R::read(s, v.size(), columns);
+		for(Size_t k=0;ok && (k<v.size());++k)
+			ok = (rows[k].tuple() == v[k].tuple()) && (std::get<2>(columns)[k] == v[k].get<2>()) && (std::get<4>(columns)[k] == v[k].get<4>());
+		check(ok, "Record: relecture");
+		Bits::Stream  cut = prefix(s, Size_t(v.size()*R::bits - 1));
+		check(!R::read(cut, v.size(), rows) && (rows.size() == v.size()), "Record: relecture tronquée");
+		R  one(1, 2, 3, true, 5), last = one;
+		Bits::Stream  short_stream = prefix(expected, R::bits - 1);
+		check(!(short_stream >> last) && (last.tuple() == one.tuple()), "Record: enregistrement tronqué");
+	}
+
+	/// décodage paresseux comparé au décodage complet
+	void check_decode(const Bits::Bytes &text) {
+		vector<Size_t>  values;
+		Bits::Stream  s;
+		for(Size_t i=0;i<1000;++i) {
+			values.push_back(Size_t(gen() % 8192));
+			s << Bits::Block<13>(Bits::Block<13>::Type(values.back()));
+		}
+		vector<Size_t>  all, half;
+		for(auto x : Bits::blocks<13>(s)) all.push_back(x);
+		s.seek(0);
+		auto  first = Bits::blocks<13>(s, 500);
+		for(auto x : first) half.push_back(x);
+		check((all == values) && first.valid() && equal(half.begin(), half.end(), values.begin()) && (half.size() == 500), "blocks<13>");
+		Bits::Stream  cut = prefix(s, 13*1000 - 1);
+		auto  truncated = Bits::blocks<13>(cut, 1000);
+		Size_t  n = 0;
+		for(auto it=truncated.begin();it!=truncated.end();++it) ++n;
+		check((n == 999) && !truncated.valid(), "blocks<13> tronqué");
+
+		Bits::CHuffman  huffman;
+		Bits::Stream  h;
+		huffman.encode(text.data(), Size_t(text.size()), h);
+		Bits::Bytes  out;
+		auto  symbols = Bits::symbols(huffman, h, Size_t(text.size()));
+		for(auto c : symbols) out.push_back(c);
+		check(symbols.valid() && (out == text), "symbols");
+		Bits::Stream  table = prefix(h, 1000);
+		auto  bad = Bits::symbols(huffman, table, 10);
+		check((bad.begin() == bad.end()) && !bad.valid(), "symbols: table tronquée");
+	}
+
+	/// écriture et lecture de fichier en parallèle du codage, par petits paquets
+	void check_file() {
+		const char  *path = "check.bin";
+		vector<pair<Size_t, Size_t>>  values;
+		uint64_t  total = 0;
+		{
+			Bits::FileWriter  writer(path, 64);
+			for(Size_t i=0;i<20000;++i) {
+				const Size_t  w = 1 + Size_t(gen() % 32), x = Size_t(gen()) & Bits::mask<Size_t>(0, w);
+				values.push_back({ w, x });
+				writer.stream().write_bits(x, w);
+				writer.commit();
+				total += w;
+			}
+			check((writer.bit_size() == total) && writer.close(), "FileWriter");
+		}
+		Bits::FileReader  reader(path, total, 64);
+		bool  ok = true;
+		for(const auto &v : values) ok = ok && reader.ensure(v.first) && (reader.stream().get_bits(v.first) == v.second);
+		check(ok && reader.valid() && (reader.available() == 0), "FileReader");
+		Bits::FileReader  longer(path, total + 100, 64);
+		Size_t  read = 0;
+		while (longer.ensure(32)) { longer.stream().get_bits(32); read += 32; }
+		check(!longer.valid() && (read + longer.available() == (total + 7) / 8 * 8), "FileReader: fichier trop court");
+		std::remove(path);
+	}
+
+	/// instantanés: chaque écriture d'un flux qui partage ses données (avec freeze, ou construit sur un
+	/// instantané) recopie les données; l'instantané et les autres lecteurs ne changent pas
+	template <class F> void check_cow(const string &what, F op) {
+		Bits::Stream  s = random_bits(900, 0.5);
+		const Bits::Stream::Checkpoint  c = s.mark();
+		s.write_bits(0x12345, 20);
+		for(Size_t i=0;i<80;++i) s.write_bits(i & 1, 1);
+		Bits::Stream  ref(s), ref2(s);
+		const Bits::Stream  original(s);
+		const Bits::Stream::Frozen  f = s.freeze();
+		Bits::Stream  reader(f);
+		op(s, c);
+		op(ref, c);
+		check(s.is_shared() == false && (s == ref), what + ": flux modifié");
+		check((Bits::Stream(f) == original) && (reader == original), what + ": instantané inchangé");
+		op(reader, c);
+		op(ref2, c);
+		check((reader == ref2) && (Bits::Stream(f) == original), what + ": lecteur de l'instantané modifié");
+	}
+	void check_freeze() {
+		using C = const Bits::Stream::Checkpoint&;
+		check_cow("write_bits", [](Bits::Stream &s, C) { s.write_bits(5, 3); });
+		check_cow("Block", [](Bits::Stream &s, C) { s << Bits::Block<45>(0x123456789ABull); });
+		check_cow("varBlock", [](Bits::Stream &s, C) { s << Bits::varBlock(7, 0x55); });
+		check_cow("bit", [](Bits::Stream &s, C) { s << true << false; });
+		check_cow("entier", [](Bits::Stream &s, C) { s << uint32_t(0xDEADBEEF); });
+		check_cow("write_msb", [](Bits::Stream &s, C) { s.write_msb(0xABCDEF0123ull, 40); });
+		check_cow("write_bytes", [](Bits::Stream &s, C) { s.write_bytes("abc", 3); });
+		check_cow("copy_bits", [](Bits::Stream &s, C) { s.copy_bits(s, 3, 700); });
+		check_cow("append", [](Bits::Stream &s, C) { s.append(s); });
+		check_cow("write_seek", [](Bits::Stream &s, C) { s.write_seek(500); s.write_bits(1, 1); });
+		check_cow("rollback", [](Bits::Stream &s, C c) { s.rollback(c); });
+		check_cow("combine_assign", [](Bits::Stream &s, C) { s ^= s; });
+		check_cow("request_storage_size", [](Bits::Stream &s, C) { s.request_storage_size(100000); s.write_bits(3, 2); });
+		check_cow("own", [](Bits::Stream &s, C) { s.own(); s.get_data()[0] ^= 1; });
+		check_cow("reset", [](Bits::Stream &s, C) { s.reset(); s.write_bits(7, 3); });
+	}
+
+	/// codeurs: aller-retour, curseur après les données, données tronquées, taille d'entête fabriquée
+	void check_codec(Bits::Codec &codec, const string &label, const vector<Bits::Bytes> &inputs, bool crafted) {
+		for(size_t k=0;k<inputs.size();++k) {
+			const Bits::Bytes  &data = inputs[k];
+			const string  what = label + " données " + str(k);
+			Bits::Stream  s;
+			codec.compress(data, s);
+			s.write_bits(0x3FF, 10);	// données qui suivent le bloc
+			Bits::Bytes  out;
+			check(codec.decompress(s, out) && (out == data) && (s.get_bit_size() - s.getReadPosition().LastBit() == 10), what + ": aller-retour");
+			bool  ok = true;
+			for(Size_t t : cuts(s.get_bit_size() - 10, 8)) {
+				Bits::Stream  cut = prefix(s, t);
+				try {
+					if (codec.decompress(cut, out)) ok = ok && (out.size() <= data.size());
+				} catch (const std::exception &) { ok = false; }
+			}
+			check(ok, what + ": données tronquées");
+			if (!crafted || data.empty()) continue;
+			// entête annonçant 0xFFFFFFF0 octets, suivie des données d'origine
+			Bits::Stream  big;
+			big.write_bits(codec.magic(), 32);
+			big.write_bits(0xFFFFFFF0u, 32);
+			big.copy_bits(s, 64, s.get_bit_size() - 64);
+			try {
+				check(!codec.decompress(big, out), what + ": taille fabriquée acceptée");
+			} catch (const std::exception &e) {
+				check(false, what + ": taille fabriquée (" + e.what() + ")");
+			}
+		}
+	}
+	void check_codecs(const Bits::Bytes &text) {
+		Bits::Bytes  random(5000), skewed(5000);
+		for(auto &b : random) b = Bits::Byte(gen());
+		for(auto &b : skewed) b = Bits::Byte(std::min(Size_t(gen() % 64), Size_t(gen() % 64)));
+		const Bits::Bytes  sample(text.begin(), text.begin() + long(std::min(text.size(), size_t(30000))));
+		const vector<Bits::Bytes>  inputs = { {}, { 'x', 'y', 'x' }, sample, random, skewed };
+
+		Bits::CStored	 stored;
+		Bits::CTF		 ctf;
+		Bits::CHuffman	 huffman;
+		Bits::CLZ		 lz;
+		Bits::CAdaptive  adaptive(1024, true, true);
+		Bits::CParallelHuffman  gaps(2, 1000), sync(2, 0);
+		Bits::CBWT		 bwt(4096, 2);
+		Bits::CContext	 order1(1, false), order2(2, true);
+		for(Bits::Codec *codec : { (Bits::Codec*)&stored, (Bits::Codec*)&ctf, (Bits::Codec*)&huffman, (Bits::Codec*)&lz,
+								   (Bits::Codec*)&adaptive, (Bits::Codec*)&gaps, (Bits::Codec*)&sync })
+			check_codec(*codec, codec->name(), inputs, true);
+		check_codec(bwt, "BWT", inputs, true);
+		check_codec(order1, "Context(1)", inputs, true);
+		check_codec(order2, "Context(2)", inputs, true);
+		// bloc Bits::CHuffman suivi d'autres données, décodé en parallèle sans ou avec sa fin
+		Bits::Bytes  large;
+		while (large.size() < 200000) large.insert(large.end(), text.begin(), text.end());
+		Bits::Stream  embedded;
+		huffman.encode(large.data(), Size_t(large.size()), embedded);
+		const Size_t  block_end = embedded.get_bit_size();
+		embedded.append(random_bits(1u << 20, 0.5));
+		for(Size_t end : { Size_t(0), block_end, block_end - 1 }) {
+			Bits::CParallelHuffman  parallel(4, 0);
+			Bits::Bytes  decoded(large.size());
+			embedded.seek(0);
+			const bool  ok = parallel.decode_huffman(embedded, decoded.data(), Size_t(decoded.size()), end) && (decoded == large)
+							 && (embedded.getReadPosition().LastBit() == block_end);
+			check(ok == (end != block_end - 1), "ParallelHuffman: bloc suivi de données, fin " + str(end));
+		}
+		// BWT: bloc annonçant 0xFFFFFFF0 symboles MTF pour 16 octets
+		Bits::Stream  mtf;
+		for(Size_t v : { bwt.magic(), Size_t(16), Size_t(16), Size_t(0), Size_t(0xFFFFFFF0u), Size_t(0) }) mtf.write_bits(v, 32);
+		Bits::Bytes  out;
+		check(!bwt.decompress(mtf, out), "BWT: nombre de symboles fabriqué accepté");
+		// CTF d'un seul symbole: codes de 0 bit, la taille ne peut pas être bornée par les données
+		check_codec(ctf, "CTF un symbole", { Bits::Bytes(100, 'a') }, false);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	const char  *InputFile = (argc > 1 ? argv[1] : "USconstitution.txt");
+	ifstream  input(InputFile, std::ios::in | std::ios::binary);
+	if (!input) { cout << "impossible d'ouvrir " << InputFile << endl; return 1; }
+	const Bits::Bytes  text((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+	if (text.size() < 5000) { cout << InputFile << ": texte trop court" << endl; return 1; }
+
+	check_rank();
+	check_elias_fano();
+	check_ops();
+	check_packed_vectors();
+	check_column();
+	check_dump();
+	check_search(text);
+	check_registry(text);
+	check_batch(text);
+	check_record();
+	check_decode(text);
+	check_file();
+	check_freeze();
+	check_codecs(text);
+	cout << (failures ? to_string(failures) + " vérification(s) en échec" : string("toutes les vérifications sont passées")) << endl;
+	return failures ? 1 : 0;
+}